@@ -1,4 +1,4 @@
 echo "./schedule_processes data/process1.list data/process2.list 0 2"
 ./schedule_processes data/process1.list data/process2.list 0 2 
-#echo "./schedule_processes data/process1.list data/process2.list 1 2"
-#./schedule_processes data/process1.list data/process2.list 1 2 
+echo "./schedule_processes data/process1.list data/process2.list 1 2"
+./schedule_processes data/process1.list data/process2.list 1 2 
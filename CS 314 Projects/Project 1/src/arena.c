@@ -0,0 +1,62 @@
+/**
+ * @file arena.c
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include "arena.h"
+
+#define ALIGN_UP(n) (((n) + sizeof(max_align_t) - 1) & ~(sizeof(max_align_t) - 1))
+
+/* Adds a slab of at least min_size bytes to the arena */
+static arena_slab_t *add_slab(arena_t *arena, size_t min_size) {
+    size_t size = min_size > ARENA_SLAB_SZ ? min_size : ARENA_SLAB_SZ;
+    arena_slab_t *slab = malloc(sizeof(arena_slab_t) + size);
+
+    if (slab == NULL) return NULL;
+    slab->size = size;
+    slab->used = 0;
+
+    if (min_size > ARENA_SLAB_SZ && arena->slabs != NULL) {
+        /* an oversized object: keep carving from the current slab */
+        slab->next = arena->slabs->next;
+        arena->slabs->next = slab;
+    } else {
+        slab->next = arena->slabs;
+        arena->slabs = slab;
+    }
+    return slab;
+}
+
+void *arena_alloc(arena_t *arena, size_t size) {
+    arena_slab_t *slab = arena->slabs;
+    void *obj;
+
+    size = ALIGN_UP(size ? size : 1);
+    if (slab == NULL || slab->size - slab->used < size) {
+        slab = add_slab(arena, size);
+        if (slab == NULL) return NULL;
+    }
+
+    obj = (char *) slab->data + slab->used;
+    slab->used += size;
+    return obj;
+}
+
+char *arena_strdup(arena_t *arena, const char *str) {
+    size_t len = strlen(str) + 1;
+    char *copy = arena_alloc(arena, len);
+
+    if (copy) memcpy(copy, str, len);
+    return copy;
+}
+
+void free_arena(arena_t *arena) {
+    arena_slab_t *next;
+
+    while (arena->slabs != NULL) {
+        next = arena->slabs->next;
+        free(arena->slabs);
+        arena->slabs = next;
+    }
+}
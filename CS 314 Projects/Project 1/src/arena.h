@@ -0,0 +1,34 @@
+/**
+ * @file arena.h
+ * @description A region allocator: objects are carved from large slabs and
+ *              are all released at once when the arena is freed.
+ */
+#ifndef _ARENA_H
+#define _ARENA_H
+
+#include <stddef.h>
+
+#define ARENA_SLAB_SZ (64 * 1024)
+
+typedef struct arena_slab_t {
+  struct arena_slab_t *next;
+  size_t size;  /* usable bytes in data */
+  size_t used;
+  max_align_t data[]; /* aligned for any object */
+} arena_slab_t;
+
+/** An arena; a zero-initialised arena_t is empty and ready to use */
+typedef struct arena_t {
+  arena_slab_t *slabs; /* the slab being carved from is first */
+} arena_t;
+
+/** Returns <code>size</code> bytes from the arena, aligned for any object, or NULL */
+void *arena_alloc(arena_t *arena, size_t size);
+
+/** Returns a copy of <code>str</code> allocated in the arena */
+char *arena_strdup(arena_t *arena, const char *str);
+
+/** Releases every object allocated in the arena */
+void free_arena(arena_t *arena);
+
+#endif
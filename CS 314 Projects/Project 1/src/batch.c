@@ -0,0 +1,361 @@
+/**
+ * @file batch.c
+ *
+ * Every run of a sweep is a child process forked from the batch process, so
+ * each has its own copy of the state of the manager, the loader, the
+ * generator and the logger, and the runs cannot interfere. A workload that
+ * is the same for every run (the process files, or a generated workload
+ * without a list of seeds) is loaded once before forking and shared
+ * copy-on-write by all the runs.
+ *
+ * The runs are processes rather than threads because the state of the
+ * simulator lives in file-scope variables of each module, so a run is not
+ * reentrant; forking gives each run a private copy of that state without
+ * threading a context through every function of the manager.
+ */
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include "manager.h"
+#include "metrics.h"
+#include "batch.h"
+
+#define BATCH_DIR "batch"
+#define SUMMARY_FILENAME BATCH_DIR "/summary.csv"
+#define RUN_METRICS_FILENAME "scheduler_metrics.csv"
+#define RUN_OUTPUT_FILENAME "output.txt"
+#define NO_SEED 0
+#define MAX_LIST_LEN 1000000 // values a list may expand to
+
+/** One run of the sweep */
+typedef struct batch_run_t
+{
+    char name[64];          /* its directory under BATCH_DIR */
+    schedule_t sched;
+    int quantum;
+    unsigned long seed;     /* generator seed, NO_SEED to keep the workload's */
+    pid_t pid;              /* child running it, 0 once it has ended */
+    int status;             /* exit status of the child */
+    struct timespec start;
+    double ms;              /* wall-clock time of the run */
+} batch_run_t;
+
+static char *sched_names[] = {"priority", "RR", "FCFS", "CFS"};
+
+/**
+ * @brief Parses a comma-separated list of numbers and ranges such as
+ *        "1,4-6" into <code>values</code>.
+ *
+ * @return the number of values, -1 if the list is not valid
+ */
+static int parse_list(char *spec, long **values)
+{
+    int n = 0, sz = 8;
+    long lo, hi;
+    char *end;
+
+    *values = malloc(sz * sizeof(long));
+    while (*spec != '\0')
+    {
+        lo = hi = strtol(spec, &end, 10);
+        if (end == spec || lo < 0)
+        {
+            return -1;
+        }
+        if (*end == '-')
+        {
+            spec = end + 1;
+            hi = strtol(spec, &end, 10);
+            if (end == spec || hi < lo)
+            {
+                return -1;
+            }
+        }
+        if (hi - lo >= MAX_LIST_LEN - n)
+        {
+            return -1;
+        }
+        for (; lo <= hi; lo++)
+        {
+            if (n == sz)
+            {
+                sz *= 2;
+                *values = realloc(*values, sz * sizeof(long));
+            }
+            (*values)[n++] = lo;
+        }
+        if (*end == ',')
+        {
+            end++;
+        }
+        else if (*end != '\0')
+        {
+            return -1;
+        }
+        spec = end;
+    }
+    return n;
+}
+
+/**
+ * @brief The body of the child process of a run: moves into the run's
+ *        directory, sends its output there and runs the simulation.
+ *
+ * @param procs The shared workload, or NULL to generate it with the run's seed.
+ */
+static int run_child(batch_run_t *run, pcb_t *procs)
+{
+    char dir[sizeof(BATCH_DIR) + sizeof(run->name) + 1];
+
+    snprintf(dir, sizeof(dir), "%s/%s", BATCH_DIR, run->name);
+    if ((mkdir(dir, 0777) != 0 && errno != EEXIST) || chdir(dir) != 0)
+    {
+        perror(dir);
+        return EXIT_FAILURE;
+    }
+
+    /* the log and the metrics are appended to, so drop those of an earlier sweep */
+    remove("scheduler.log");
+    remove("scheduler.trace");
+    remove(RUN_METRICS_FILENAME);
+    if (freopen(RUN_OUTPUT_FILENAME, "w", stdout) == NULL)
+    {
+        perror(RUN_OUTPUT_FILENAME);
+        return EXIT_FAILURE;
+    }
+    dup2(fileno(stdout), STDERR_FILENO);
+    setenv("SCHED_METRICS", "csv", 1);
+
+    if (run->seed != NO_SEED)
+    {
+        get_gen_config()->seed = run->seed;
+        begin_phase(PHASE_PARSE);
+        procs = init_loader_from_generator();
+    }
+    if (procs == NULL)
+    {
+        printf("Error: no processes to schedule\n");
+        return EXIT_FAILURE;
+    }
+    run_processes(procs, run->sched, run->quantum);
+    return EXIT_SUCCESS;
+}
+
+/** Forks the child process of a run */
+static void start_run(batch_run_t *run, pcb_t *procs)
+{
+    fflush(NULL);
+    clock_gettime(CLOCK_MONOTONIC, &run->start);
+    run->pid = fork();
+    if (run->pid == 0)
+    {
+        exit(run_child(run, procs));
+    }
+    if (run->pid < 0)
+    {
+        perror("fork");
+        run->pid = 0;
+        run->status = EXIT_FAILURE;
+    }
+}
+
+/**
+ * @brief Writes batch/summary.csv: the metrics row of every run that wrote
+ *        one, prefixed with the run's name, quantum and seed.
+ */
+static void write_summary(batch_run_t *runs, int num_runs)
+{
+    FILE *out = fopen(SUMMARY_FILENAME, "w"), *in;
+    char path[sizeof(BATCH_DIR) + 64 + sizeof(RUN_METRICS_FILENAME) + 2];
+    char *header = NULL, *row = NULL;
+    size_t header_sz = 0, row_sz = 0;
+    bool_t wrote_header = FALSE;
+
+    if (out == NULL)
+    {
+        perror(SUMMARY_FILENAME);
+        return;
+    }
+    for (int i = 0; i < num_runs; i++)
+    {
+        snprintf(path, sizeof(path), "%s/%s/%s", BATCH_DIR, runs[i].name, RUN_METRICS_FILENAME);
+        in = fopen(path, "r");
+        if (in == NULL)
+        {
+            continue;
+        }
+        if (getline(&header, &header_sz, in) > 0 && getline(&row, &row_sz, in) > 0)
+        {
+            if (!wrote_header)
+            {
+                fprintf(out, "run,quantum,seed,%s", header);
+                wrote_header = TRUE;
+            }
+            fprintf(out, "%s,", runs[i].name);
+            if (runs[i].sched == RR || runs[i].sched == CFS)
+            {
+                fprintf(out, "%d", runs[i].quantum);
+            }
+            fprintf(out, ",");
+            if (runs[i].seed != NO_SEED)
+            {
+                fprintf(out, "%lu", runs[i].seed);
+            }
+            fprintf(out, ",%s", row);
+        }
+        fclose(in);
+    }
+    free(header);
+    free(row);
+    fclose(out);
+}
+
+int run_batch(int argc, char **argv)
+{
+    long *scheds = NULL, *quanta = NULL, *seeds = NULL;
+    int num_scheds, num_quanta, num_seeds = 0, num_runs = 0, jobs, running = 0, failures = 0, status;
+    batch_run_t *runs, *run;
+    pcb_t *procs = NULL;
+    pid_t pid;
+    char *data1, *data2;
+
+    if (argc < 6)
+    {
+        fprintf(stderr, "Usage: %s batch <data1> <data2> <schedulers> <quanta> [seeds] [jobs]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    data1 = argv[2];
+    data2 = argv[3];
+    num_scheds = parse_list(argv[4], &scheds);
+    num_quanta = parse_list(argv[5], &quanta);
+    if (argc > 6)
+    {
+        num_seeds = parse_list(argv[6], &seeds);
+    }
+    jobs = (argc > 7) ? atoi(argv[7]) : (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (num_scheds <= 0 || num_quanta <= 0 || num_seeds < 0 || jobs < 1)
+    {
+        fprintf(stderr, "batch: invalid schedulers, quanta, seeds or jobs\n");
+        return EXIT_FAILURE;
+    }
+    for (int i = 0; i < num_scheds; i++)
+    {
+        if (scheds[i] > CFS)
+        {
+            fprintf(stderr, "batch: unknown scheduler %ld\n", scheds[i]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (num_seeds > 0 && strcmp(data1, "generate") != 0)
+    {
+        fprintf(stderr, "batch: seeds only apply to generated workloads, ignored\n");
+        num_seeds = 0;
+    }
+
+    /* load a workload shared by all runs once; otherwise only check the settings */
+    begin_phase(PHASE_PARSE);
+    if (num_seeds == 0)
+    {
+        procs = load_processes(data1, data2);
+        if (procs == NULL)
+        {
+            printf("Error: no processes to schedule\n");
+            return EXIT_FAILURE;
+        }
+    }
+    else if (!configure_generator(data2))
+    {
+        return EXIT_FAILURE;
+    }
+
+    /* every scheduler with every seed; only RR and CFS run once per quantum */
+    runs = calloc((size_t)num_scheds * num_quanta * (num_seeds > 0 ? num_seeds : 1), sizeof(batch_run_t));
+    for (int s = 0; s < num_scheds; s++)
+    {
+        for (int q = 0; q < ((scheds[s] == RR || scheds[s] == CFS) ? num_quanta : 1); q++)
+        {
+            for (int k = 0; k < (num_seeds > 0 ? num_seeds : 1); k++)
+            {
+                run = &runs[num_runs++];
+                run->sched = scheds[s];
+                run->quantum = quanta[q];
+                run->seed = (num_seeds > 0) ? (unsigned long)seeds[k] : NO_SEED;
+                snprintf(run->name, sizeof(run->name), "%s", sched_names[run->sched]);
+                if (run->sched == RR || run->sched == CFS)
+                {
+                    snprintf(run->name + strlen(run->name), sizeof(run->name) - strlen(run->name), "-q%d", run->quantum);
+                }
+                if (run->seed != NO_SEED)
+                {
+                    snprintf(run->name + strlen(run->name), sizeof(run->name) - strlen(run->name), "-s%lu", run->seed);
+                }
+            }
+        }
+    }
+
+    if (mkdir(BATCH_DIR, 0777) != 0 && errno != EEXIST)
+    {
+        perror(BATCH_DIR);
+        return EXIT_FAILURE;
+    }
+    printf("Batch: %d runs, %d at a time\n", num_runs, jobs);
+
+    /* keep up to jobs children running until every run has ended */
+    for (int next = 0; next < num_runs || running > 0;)
+    {
+        if (next < num_runs && running < jobs)
+        {
+            start_run(&runs[next], procs);
+            if (runs[next].pid > 0)
+            {
+                running++;
+            }
+            else
+            {
+                failures++;
+            }
+            next++;
+            continue;
+        }
+
+        pid = wait(&status);
+        if (pid < 0)
+        {
+            perror("wait");
+            break;
+        }
+        for (run = runs; run < runs + next && run->pid != pid; run++);
+        if (run == runs + next)
+        {
+            continue;
+        }
+        run->ms = ms_since(&run->start);
+        run->pid = 0;
+        run->status = (WIFEXITED(status)) ? WEXITSTATUS(status) : EXIT_FAILURE;
+        running--;
+        if (run->status != EXIT_SUCCESS)
+        {
+            failures++;
+        }
+        printf("%-24s %s in %.1f ms\n", run->name, (run->status == EXIT_SUCCESS) ? "done" : "failed", run->ms);
+    }
+
+    write_summary(runs, num_runs);
+    printf("Batch: %d of %d runs failed, metrics in %s\n", failures, num_runs, SUMMARY_FILENAME);
+    if (procs != NULL)
+    {
+        dealloc_data_structures();
+    }
+    free(runs);
+    free(scheds);
+    free(quanta);
+    free(seeds);
+    return (failures == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
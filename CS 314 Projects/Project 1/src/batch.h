@@ -0,0 +1,29 @@
+/**
+ * @file batch.h
+ * @description Parameter sweeps: one workload run with every combination of
+ *              schedulers, time quanta and generator seeds, the runs spread
+ *              over a pool of child processes across all cores.
+ */
+#ifndef _BATCH_H
+#define _BATCH_H
+
+/**
+ * @brief Runs a sweep given on the command line:
+ *
+ *     batch <data1> <data2> <schedulers> <quanta> [seeds] [jobs]
+ *
+ * <code>data1</code> and <code>data2</code> select the workload as for a
+ * single run. <code>schedulers</code>, <code>quanta</code> and
+ * <code>seeds</code> are lists of numbers and ranges, e.g. "0,2" or "1-20".
+ * The quanta only apply to RR and CFS; the seeds replace the generator's seed, so
+ * they only apply to generated workloads. At most <code>jobs</code> runs
+ * (default: one per online core) execute at once, each in its own child
+ * process and in its own directory batch/&lt;run&gt;, which receives its
+ * scheduler.log, its printed output and its metrics. The metrics of all the
+ * runs are collected in batch/summary.csv.
+ *
+ * @return EXIT_SUCCESS if every run succeeded
+ */
+int run_batch(int argc, char **argv);
+
+#endif
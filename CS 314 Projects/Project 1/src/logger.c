@@ -3,111 +3,439 @@
 #include <string.h>
 #include <stdarg.h>
 #include <time.h>
+#include <pthread.h>
 #include "logger.h"
+#include "sim.h"
+#include "trace.h"
 
-/* Open the file for the current thread: in append mode */
-FILE* open_logfile() {
-    FILE* fptr = NULL;
-    char* filename = NULL;
+#define LOG_FILENAME "scheduler.log"
+#define LOG_MODE_ENV "SCHED_LOG_MODE"
+#define VERBOSITY_ENV "SCHED_VERBOSITY"
+#define LOG_BUF_SZ (1 << 20)     /* bytes held in memory before a write */
+#define LOG_LINE_SZ 512          /* longest single formatted log line */
+#define LOG_FLUSH_SECS 1         /* flush at least this often (wall clock) */
 
-    if (!filename) {
-        filename = malloc(64*sizeof(char));
-        if (filename)
-            sprintf(filename,"scheduler.log");
-        else
-            return NULL;
+/** Open-addressing table that interns the strings written to the trace */
+typedef struct trace_str_t {
+    char *str;
+    uint32_t id;
+} trace_str_t;
+
+static void flush_buf(sim_t *sim);
+static void close_sink(sim_t *sim);
+static void append_log(sim_t *sim, const void *bytes, size_t len);
+
+/**
+ * @brief Sets the logger of a new simulation to the mode and verbosity chosen
+ *        with the SCHED_LOG_MODE and SCHED_VERBOSITY environment variables,
+ *        see set_log_mode() and set_verbosity(). The log file is only opened
+ *        by the first event.
+ */
+void init_logger(sim_t *sim) {
+    char *mode = getenv(LOG_MODE_ENV), *level = getenv(VERBOSITY_ENV);
+    logger_t *log = &sim->log;
+
+    log->mode = LOG_BUFFERED;
+    if (mode && strcmp(mode, "sync") == 0)
+        log->mode = LOG_SYNC;
+    else if (mode && strcmp(mode, "trace") == 0)
+        log->mode = LOG_TRACE;
+
+    log->verbosity = VERBOSE_DEBUG;
+    if (level && (strcmp(level, "quiet") == 0 || strcmp(level, "0") == 0))
+        log->verbosity = VERBOSE_QUIET;
+    else if (level && (strcmp(level, "events") == 0 || strcmp(level, "1") == 0))
+        log->verbosity = VERBOSE_EVENTS;
+
+    log->fptr = NULL;
+    log->buf = NULL;
+    log->len = 0;
+    log->last_flush = 0;
+    log->tick = 0;
+    log->trace_strs = NULL;
+    log->trace_strs_sz = 0;
+    log->trace_strs_used = 0;
+}
+
+/**
+ * @brief Selects how lines are written to scheduler.log.
+ *
+ * LOG_BUFFERED keeps the log file open and collects lines in memory, writing
+ * them out when the buffer fills, when LOG_FLUSH_SECS have passed and when
+ * the log is closed. LOG_SYNC writes and flushes every line as it is logged.
+ * LOG_TRACE skips all
+ * text formatting and writes fixed-size binary records (see trace.h) to
+ * scheduler.trace instead; tools/trace_decode turns them back into text. The
+ * mode can also be chosen with the SCHED_LOG_MODE environment variable
+ * ("buffered", "sync" or "trace").
+ */
+void set_log_mode(sim_t *sim, log_mode_t mode) {
+    pthread_mutex_lock(&sim->log.lock);
+    if (mode != sim->log.mode)
+        close_sink(sim); /* reopened on the next event, on the right sink */
+    else
+        flush_buf(sim);
+    sim->log.mode = mode;
+    pthread_mutex_unlock(&sim->log.lock);
+}
+
+/* Open the log file of the simulation once, in append mode */
+static void init_log(sim_t *sim) {
+    logger_t *log = &sim->log;
+    char *filename;
+
+    if (!log->fptr) {
+        filename = sim_path(sim, (log->mode == LOG_TRACE) ? TRACE_FILENAME : LOG_FILENAME);
+        log->fptr = fopen(filename, (log->mode == LOG_TRACE) ? "ab" : "a");
+        if (!log->fptr) {
+            fprintf(sim->err, "Error opening %s\n", filename);
+            free(filename);
+            return;
+        }
+        free(filename);
+        setvbuf(log->fptr, NULL, _IONBF, 0);
+        if (!log->buf)
+            log->buf = malloc(LOG_BUF_SZ);
+        log->last_flush = time(NULL);
+        if (log->mode == LOG_TRACE) {
+            trace_rec_t header = {TRACE_HEADER, TRACE_MAGIC, TRACE_VERSION, TRACE_NONE, 0};
+            append_log(sim, &header, sizeof(trace_rec_t));
+        }
+    }
+}
+
+/**
+ * @brief Sets how much is printed to the output of the simulation.
+ *
+ * VERBOSE_QUIET prints only errors and end-of-run summaries, VERBOSE_EVENTS
+ * also echoes every logged event and the loaded processes, and VERBOSE_DEBUG
+ * (the default) adds the queue dumps of builds with DEBUG_MNGR or
+ * DEBUG_LOADER. The level can also be chosen with the SCHED_VERBOSITY
+ * environment variable ("quiet", "events" or "debug", or 0 to 2). The log
+ * file is written the same way at every level.
+ */
+void set_verbosity(sim_t *sim, verbosity_t level) {
+    sim->log.verbosity = level;
+}
+
+/** Returns the verbosity level, see set_verbosity() */
+verbosity_t get_verbosity(sim_t *sim) {
+    return sim->log.verbosity;
+}
+
+/* Print an event to the output, unless the verbosity level is below VERBOSE_EVENTS */
+static void echo(sim_t *sim, const char *fmt, ...) {
+    va_list args;
+
+    if (sim->log.verbosity < VERBOSE_EVENTS)
+        return;
+    va_start(args, fmt);
+    vfprintf(sim->out, fmt, args);
+    va_end(args);
+}
+
+/** Sets the logical clock stamped on trace records */
+void set_log_tick(sim_t *sim, unsigned long tick) {
+    __atomic_store_n(&sim->log.tick, tick, __ATOMIC_RELAXED);
+}
+
+/* Write everything buffered so far to the log file, with the log's lock held */
+static void flush_buf(sim_t *sim) {
+    logger_t *log = &sim->log;
+
+    if (log->fptr && log->len > 0) {
+        fwrite(log->buf, sizeof(char), log->len, log->fptr);
+        log->len = 0;
+    }
+    log->last_flush = time(NULL);
+}
+
+/* Write everything buffered so far to the log file */
+void flush_log(sim_t *sim) {
+    pthread_mutex_lock(&sim->log.lock);
+    flush_buf(sim);
+    pthread_mutex_unlock(&sim->log.lock);
+}
+
+/* Flush and close the log file */
+void close_log(sim_t *sim) {
+    pthread_mutex_lock(&sim->log.lock);
+    close_sink(sim);
+    pthread_mutex_unlock(&sim->log.lock);
+}
+
+/* Flush and close the log file, with the log's lock held */
+static void close_sink(sim_t *sim) {
+    logger_t *log = &sim->log;
+    size_t i;
+
+    flush_buf(sim);
+    if (log->fptr) {
+        fclose(log->fptr);
+        log->fptr = NULL;
+    }
+    free(log->buf);
+    log->buf = NULL;
+
+    for (i = 0; i < log->trace_strs_sz; i++)
+        free(log->trace_strs[i].str);
+    free(log->trace_strs);
+    log->trace_strs = NULL;
+    log->trace_strs_sz = 0;
+    log->trace_strs_used = 0;
+}
+
+/* Append a formatted line to the log file */
+static void write_log(sim_t *sim, const char *fmt, ...) {
+    logger_t *log = &sim->log;
+    va_list args;
+    int n;
+
+    init_log(sim);
+    if (!log->fptr)
+        return;
+
+    if (log->len + LOG_LINE_SZ > LOG_BUF_SZ)
+        flush_buf(sim);
+
+    va_start(args, fmt);
+    n = vsnprintf(log->buf + log->len, LOG_BUF_SZ - log->len, fmt, args);
+    va_end(args);
+    if (n > 0)
+        log->len += ((size_t) n < LOG_BUF_SZ - log->len) ? (size_t) n : LOG_BUF_SZ - log->len - 1;
+
+    if (log->mode == LOG_SYNC || time(NULL) - log->last_flush >= LOG_FLUSH_SECS)
+        flush_buf(sim);
+}
+
+/* Append raw bytes to the log buffer, flushing first if they do not fit */
+static void append_log(sim_t *sim, const void *bytes, size_t len) {
+    logger_t *log = &sim->log;
+
+    if (log->len + len > LOG_BUF_SZ)
+        flush_buf(sim);
+    if (len > LOG_BUF_SZ) {
+        fwrite(bytes, 1, len, log->fptr);
+        return;
     }
+    memcpy(log->buf + log->len, bytes, len);
+    log->len += len;
+}
+
+/* FNV-1a hash of a string */
+static size_t hash_str(const char *str) {
+    size_t h = 2166136261u;
+    for (; *str; str++)
+        h = (h ^ (unsigned char) *str) * 16777619u;
+    return h;
+}
 
-    fptr = fopen(filename, "a");
-    if (!fptr)
-        return NULL; 
+/* Returns the slot holding str, or the empty slot where it belongs */
+static trace_str_t *find_trace_str(logger_t *log, const char *str) {
+    size_t i = hash_str(str) & (log->trace_strs_sz - 1);
 
-    free(filename);
-    return fptr;
+    while (log->trace_strs[i].str && strcmp(log->trace_strs[i].str, str) != 0)
+        i = (i + 1) & (log->trace_strs_sz - 1);
+    return &log->trace_strs[i];
 }
 
-/* Close the logfile pointed to by fptr */
-void close_logfile(FILE* fptr) {
-    fclose(fptr);
+/* Doubles the string table once it is half full */
+static void grow_trace_strs(logger_t *log) {
+    trace_str_t *old = log->trace_strs;
+    size_t old_sz = log->trace_strs_sz, i;
+
+    log->trace_strs_sz = old_sz ? old_sz * 2 : 256;
+    log->trace_strs = calloc(log->trace_strs_sz, sizeof(trace_str_t));
+    for (i = 0; i < old_sz; i++)
+        if (old[i].str)
+            *find_trace_str(log, old[i].str) = old[i];
+    free(old);
+}
+
+/**
+ * Returns the trace id of str. The first time a string is seen it is given
+ * the next id and a TRACE_STRING record carrying its bytes is written.
+ */
+static uint32_t trace_str_id(sim_t *sim, const char *str) {
+    logger_t *log = &sim->log;
+    trace_str_t *slot;
+    trace_rec_t rec;
+    char pad[sizeof(trace_rec_t)] = {0};
+    size_t len;
+
+    if (!str)
+        return TRACE_NONE;
+    if (2 * (log->trace_strs_used + 1) > log->trace_strs_sz)
+        grow_trace_strs(log);
+
+    slot = find_trace_str(log, str);
+    if (!slot->str) {
+        len = strlen(str);
+        slot->str = malloc(len + 1);
+        memcpy(slot->str, str, len + 1);
+        slot->id = ++log->trace_strs_used;
+
+        rec.type = TRACE_STRING;
+        rec.proc = slot->id;
+        rec.resource = len;
+        rec.msg = TRACE_NONE;
+        rec.tick = __atomic_load_n(&log->tick, __ATOMIC_RELAXED);
+        append_log(sim, &rec, sizeof(rec));
+        append_log(sim, str, len);
+        if (len % sizeof(trace_rec_t))
+            append_log(sim, pad, sizeof(trace_rec_t) - len % sizeof(trace_rec_t));
+    }
+    return slot->id;
+}
+
+/**
+ * Writes a binary record for an event if the logger is in LOG_TRACE mode.
+ *
+ * @return TRUE (1) if the event was traced and no text should be logged
+ */
+static int write_trace(sim_t *sim, trace_event_t type, char *proc_name, char *resource_name, char *msg) {
+    logger_t *log = &sim->log;
+    trace_rec_t rec;
+
+    init_log(sim);
+    if (log->mode != LOG_TRACE)
+        return 0;
+    if (!log->fptr)
+        return 1;
+
+    rec.type = type;
+    rec.proc = trace_str_id(sim, proc_name);
+    rec.resource = trace_str_id(sim, resource_name);
+    rec.msg = trace_str_id(sim, msg);
+    rec.tick = __atomic_load_n(&log->tick, __ATOMIC_RELAXED);
+    append_log(sim, &rec, sizeof(rec));
+
+    if (time(NULL) - log->last_flush >= LOG_FLUSH_SECS)
+        flush_buf(sim);
+    return 1;
 }
 
 /* Logging request resource */
-void log_request_acquired(char* proc_name, char* resource_name) {
-    FILE* fptr = open_logfile();
-    fprintf(fptr, "%s req %s: acquired\n", proc_name, resource_name);    
-    printf("%s req %s: acquired\n", proc_name, resource_name);    
-    fflush(fptr);
-    close_logfile(fptr);
-}
-
-void log_request_waiting(char* proc_name, char* resource_name) {
-    FILE* fptr = open_logfile();
-    fprintf(fptr, "%s req %s: waiting\n", proc_name, resource_name);    
-    printf("%s req %s: waiting\n", proc_name, resource_name);    
-    fflush(fptr);
-    close_logfile(fptr);
-}
-
-void log_request_ready(char* proc_name) {
-    FILE* fptr = open_logfile();
-    fprintf(fptr, "%s: ready\n", proc_name);    
-    printf("%s: ready\n", proc_name);    
-    fflush(fptr);
-    close_logfile(fptr);
-}
-
-void log_release_released(char* proc_name, char* resource_name) {
-    FILE* fptr = open_logfile();
-    fprintf(fptr, "%s rel %s: released\n", proc_name, resource_name);
-    printf("%s rel %s: released\n", proc_name, resource_name);
-    fflush(fptr);
-    close_logfile(fptr);
-}
-
-void log_release_error(char* proc_name, char* resource_name) {
-    FILE* fptr = open_logfile();
-    fprintf(fptr, "%s rel %s: error nothing to release\n", proc_name, resource_name);
-    printf("%s rel %s: error nothing to release\n", proc_name, resource_name);
-    fflush(fptr);
-    close_logfile(fptr);
-}
-
-void log_terminated(char *proc_name) {
-    FILE* fptr = open_logfile();
-//    fprintf(fptr, "%s terminated\n", proc_name);
-    printf("%s terminated\n", proc_name);
-    fflush(fptr);
-    close_logfile(fptr);
-}
-
-void log_send(char *proc_name, char* msg, char* mailbox) {
-    FILE* fptr = open_logfile();
-    fprintf(fptr, "%s sending message%s to mailbox %s\n", proc_name, msg, mailbox);
-    printf("%s sending message%s to mailbox %s\n", proc_name, msg, mailbox);
-    fflush(fptr);
-    close_logfile(fptr);
-}
-
-void log_recv(char *proc_name, char* msg, char* mailbox) {
-    FILE* fptr = open_logfile();
-    fprintf(fptr, "%s received message%s from mailbox %s\n", proc_name, msg, mailbox); 
-    printf("%s received message%s from mailbox %s\n", proc_name, msg, mailbox); 
-    fflush(fptr);
-    close_logfile(fptr);
-}
-
-void log_deadlock_detected() {
-    FILE* fptr = open_logfile();
-    fprintf(fptr, "Deadlock detected:");
-    printf("Deadlock detected:");
-    fflush(fptr);
-    close_logfile(fptr);
-}
-
-void log_blocked_procs() {
-    FILE* fptr = open_logfile();
-    fprintf(fptr, "No deadlock detected, but blocked process(es) found:");
-    printf("No deadlock detected, but blocked process(es) found:");
-    fflush(fptr);
-    close_logfile(fptr);
+void log_request_acquired(sim_t *sim, char* proc_name, char* resource_name) {
+    pthread_mutex_lock(&sim->log.lock);
+    if (!write_trace(sim, TRACE_ACQUIRED, proc_name, resource_name, NULL)) {
+        write_log(sim, "%s req %s: acquired\n", proc_name, resource_name);
+        echo(sim, "%s req %s: acquired\n", proc_name, resource_name);
+    }
+    pthread_mutex_unlock(&sim->log.lock);
+}
+
+void log_request_waiting(sim_t *sim, char* proc_name, char* resource_name) {
+    pthread_mutex_lock(&sim->log.lock);
+    if (!write_trace(sim, TRACE_WAITING, proc_name, resource_name, NULL)) {
+        write_log(sim, "%s req %s: waiting\n", proc_name, resource_name);
+        echo(sim, "%s req %s: waiting\n", proc_name, resource_name);
+    }
+    pthread_mutex_unlock(&sim->log.lock);
+}
+
+void log_request_ready(sim_t *sim, char* proc_name) {
+    pthread_mutex_lock(&sim->log.lock);
+    if (!write_trace(sim, TRACE_READY, proc_name, NULL, NULL)) {
+        write_log(sim, "%s: ready\n", proc_name);
+        echo(sim, "%s: ready\n", proc_name);
+    }
+    pthread_mutex_unlock(&sim->log.lock);
+}
+
+void log_release_released(sim_t *sim, char* proc_name, char* resource_name) {
+    pthread_mutex_lock(&sim->log.lock);
+    if (!write_trace(sim, TRACE_RELEASED, proc_name, resource_name, NULL)) {
+        write_log(sim, "%s rel %s: released\n", proc_name, resource_name);
+        echo(sim, "%s rel %s: released\n", proc_name, resource_name);
+    }
+    pthread_mutex_unlock(&sim->log.lock);
+}
+
+void log_release_error(sim_t *sim, char* proc_name, char* resource_name) {
+    pthread_mutex_lock(&sim->log.lock);
+    if (!write_trace(sim, TRACE_RELEASE_ERROR, proc_name, resource_name, NULL)) {
+        write_log(sim, "%s rel %s: error nothing to release\n", proc_name, resource_name);
+        echo(sim, "%s rel %s: error nothing to release\n", proc_name, resource_name);
+    }
+    pthread_mutex_unlock(&sim->log.lock);
+}
+
+void log_terminated(sim_t *sim, char *proc_name) {
+    pthread_mutex_lock(&sim->log.lock);
+    if (!write_trace(sim, TRACE_TERMINATED, proc_name, NULL, NULL)) {
+//        write_log(sim, "%s terminated\n", proc_name);
+        echo(sim, "%s terminated\n", proc_name);
+    }
+    pthread_mutex_unlock(&sim->log.lock);
+}
+
+void log_send(sim_t *sim, char *proc_name, char* msg, char* mailbox) {
+    pthread_mutex_lock(&sim->log.lock);
+    if (!write_trace(sim, TRACE_SEND, proc_name, mailbox, msg)) {
+        write_log(sim, "%s sending message%s to mailbox %s\n", proc_name, msg, mailbox);
+        echo(sim, "%s sending message%s to mailbox %s\n", proc_name, msg, mailbox);
+    }
+    pthread_mutex_unlock(&sim->log.lock);
+}
+
+void log_recv(sim_t *sim, char *proc_name, char* msg, char* mailbox) {
+    pthread_mutex_lock(&sim->log.lock);
+    if (!write_trace(sim, TRACE_RECV, proc_name, mailbox, msg)) {
+        write_log(sim, "%s received message%s from mailbox %s\n", proc_name, msg, mailbox);
+        echo(sim, "%s received message%s from mailbox %s\n", proc_name, msg, mailbox);
+    }
+    pthread_mutex_unlock(&sim->log.lock);
+}
+
+void log_send_waiting(sim_t *sim, char *proc_name, char* mailbox) {
+    pthread_mutex_lock(&sim->log.lock);
+    if (!write_trace(sim, TRACE_SEND_WAITING, proc_name, mailbox, NULL)) {
+        write_log(sim, "%s send %s: waiting\n", proc_name, mailbox);
+        echo(sim, "%s send %s: waiting\n", proc_name, mailbox);
+    }
+    pthread_mutex_unlock(&sim->log.lock);
+}
+
+void log_recv_waiting(sim_t *sim, char *proc_name, char* mailbox) {
+    pthread_mutex_lock(&sim->log.lock);
+    if (!write_trace(sim, TRACE_RECV_WAITING, proc_name, mailbox, NULL)) {
+        write_log(sim, "%s recv %s: waiting\n", proc_name, mailbox);
+        echo(sim, "%s recv %s: waiting\n", proc_name, mailbox);
+    }
+    pthread_mutex_unlock(&sim->log.lock);
+}
+
+/* Logs the names of a list of processes, ending the line */
+static void log_proc_names(sim_t *sim, char **proc_names, int num_procs) {
+    int i;
+
+    for (i = 0; i < num_procs; i++) {
+        if (write_trace(sim, TRACE_MEMBER, proc_names[i], NULL, NULL)) continue;
+        write_log(sim, " %s", proc_names[i]);
+        echo(sim, " %s", proc_names[i]);
+    }
+    if (write_trace(sim, TRACE_END, NULL, NULL, NULL)) return;
+    write_log(sim, "\n");
+    echo(sim, "\n");
+}
+
+void log_deadlock_detected(sim_t *sim, char **proc_names, int num_procs) {
+    pthread_mutex_lock(&sim->log.lock);
+    if (!write_trace(sim, TRACE_DEADLOCK, NULL, NULL, NULL)) {
+        write_log(sim, "Deadlock detected:");
+        echo(sim, "Deadlock detected:");
+    }
+    log_proc_names(sim, proc_names, num_procs);
+    pthread_mutex_unlock(&sim->log.lock);
+}
+
+void log_blocked_procs(sim_t *sim, char **proc_names, int num_procs) {
+    pthread_mutex_lock(&sim->log.lock);
+    if (!write_trace(sim, TRACE_BLOCKED, NULL, NULL, NULL)) {
+        write_log(sim, "No deadlock detected, but blocked process(es) found:");
+        echo(sim, "No deadlock detected, but blocked process(es) found:");
+    }
+    log_proc_names(sim, proc_names, num_procs);
+    pthread_mutex_unlock(&sim->log.lock);
 }
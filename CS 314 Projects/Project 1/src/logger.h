@@ -6,16 +6,34 @@
 #ifndef LOGGER_H
 #define LOGGER_H
 
+#include "proc_structs.h"
+
+/** How log lines reach scheduler.log, see set_log_mode() */
+typedef enum {LOG_BUFFERED = 0, LOG_SYNC, LOG_TRACE} log_mode_t;
+
+/** How much is printed to stdout, see set_verbosity() */
+typedef enum {VERBOSE_QUIET = 0, VERBOSE_EVENTS, VERBOSE_DEBUG} verbosity_t;
+
 /* Functions */
-void log_request_acquired(char* proc_name, char* resource_name);
-void log_request_waiting(char* proc_name, char* resource_name);
-void log_request_ready(char* proc_name);
-void log_release_released(char* proc_name, char* resource_name);
-void log_release_error(char* proc_name, char* resource_name);
-void log_terminated(char *proc_name);
-void log_send(char *proc_name, char* msg, char* mailbox);
-void log_recv(char *proc_name, char* msg, char* mailbox);
-void log_deadlock_detected();
-void log_blocked_procs();
+void init_logger(sim_t *sim);
+void set_verbosity(sim_t *sim, verbosity_t level);
+verbosity_t get_verbosity(sim_t *sim);
+void set_log_mode(sim_t *sim, log_mode_t mode);
+void flush_log(sim_t *sim);
+void close_log(sim_t *sim);
+void set_log_tick(sim_t *sim, unsigned long tick);
+
+void log_request_acquired(sim_t *sim, char* proc_name, char* resource_name);
+void log_request_waiting(sim_t *sim, char* proc_name, char* resource_name);
+void log_request_ready(sim_t *sim, char* proc_name);
+void log_release_released(sim_t *sim, char* proc_name, char* resource_name);
+void log_release_error(sim_t *sim, char* proc_name, char* resource_name);
+void log_terminated(sim_t *sim, char *proc_name);
+void log_send(sim_t *sim, char *proc_name, char* msg, char* mailbox);
+void log_recv(sim_t *sim, char *proc_name, char* msg, char* mailbox);
+void log_send_waiting(sim_t *sim, char *proc_name, char* mailbox);
+void log_recv_waiting(sim_t *sim, char *proc_name, char* mailbox);
+void log_deadlock_detected(sim_t *sim, char **proc_names, int num_procs);
+void log_blocked_procs(sim_t *sim, char **proc_names, int num_procs);
 
 #endif
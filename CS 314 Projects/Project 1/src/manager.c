@@ -4,15 +4,27 @@
  */
 
 #include <limits.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 #include "proc_structs.h"
 #include "proc_syntax.h"
 #include "logger.h"
 #include "manager.h"
+#include "pcb_heap.h"
+#include "pcb_tree.h"
+#include "metrics.h"
+#include "batch.h"
 
 #define LOWEST_PRIORITY -1 // Use INT_MAX if 0 has the highest priority
+#define NOT_WAITING -1
+#define MAX_ROLLBACKS 10 // a victim rolled back this often is terminated instead
+#define THREADS_ENV "SCHED_THREADS"
+#define MAILBOX_CAPACITY 8 // messages a mailbox holds before senders block, a power of two
+#define WORD_BITS (8 * (int)sizeof(unsigned long)) // bits in a word of a bitset
+#define CFS_TICK_VRUNTIME (1UL << 16) // virtual runtime of one tick at the weight of priority 0
 
 int num_processes = 0;
 int scheduler = 0;
@@ -21,55 +33,287 @@ int scheduler = 0;
  * The queues as required by the spec
  */
 static pcb_queue_t terminatedq;
-static pcb_queue_t waitingq;
+static pcb_queue_t *waitqs = NULL;  /* resource id -> FIFO of processes waiting for it */
+static int num_waitqs = 0;
 static pcb_queue_t readyq;
 static bool_t readyq_updated;
+static pcb_heap_t readyh;            /* ready queue of the priority scheduler */
+static pcb_tree_t readyt;            /* ready queue of the completely fair scheduler */
+static pcb_t *last_ready = NULL;     /* pcb most recently made ready during this dispatch */
+static pcb_heap_t arrivals;          /* processes yet to arrive, earliest arrival first */
 
-void schedule_fcfs();
-void schedule_rr(int quantum);
-void schedule_pri_w_pre();
+/** How the ready queue is ordered: readyq, readyh or readyt */
+typedef enum {READY_FIFO = 0, READY_HEAP, READY_TREE} ready_order_t;
+
+static ready_order_t ready_order = READY_FIFO; /* the order of the ready queue in use */
+static unsigned long min_vruntime = 0; /* highest virtual runtime dispatched, the floor of a process made ready */
+
+/** How a tick of a dispatch ends, see run_tick(); every event but EVENT_NONE ends the dispatch */
+typedef enum {EVENT_NONE = 0, EVENT_COMPLETION, EVENT_BLOCK, EVENT_QUANTUM_EXPIRY, EVENT_PREEMPTION} event_t;
+
+/**
+ * A scheduling policy: how the ready queue is ordered and when a running
+ * process gives up its CPU. The event loop (run_events()), the SMP mode and
+ * the worker threads all run the processes through the policy, so a new
+ * scheduler is a new entry of policies[].
+ */
+typedef struct sched_policy_t
+{
+    char *name;
+    ready_order_t order; /* how the ready queue is ordered */
+    bool_t sliced;       /* a process is preempted once it has run for the quantum */
+    bool_t (*preempts)(pcb_t *ready, pcb_t *running); /* TRUE if ready preempts running; NULL if no process does */
+    void (*charge)(pcb_t *running); /* accounts a tick run by running; NULL if nothing is accounted */
+} sched_policy_t;
+
+bool_t outranks(pcb_t *ready, pcb_t *running);
+bool_t fair_preempts(pcb_t *ready, pcb_t *running);
+void charge_vruntime(pcb_t *running);
+
+static sched_policy_t policies[] = {
+    {"priority", READY_HEAP, FALSE, outranks, NULL},        /* PRIOR */
+    {"RR", READY_FIFO, TRUE, NULL, NULL},                   /* RR */
+    {"FCFS", READY_FIFO, FALSE, NULL, NULL},                /* FCFS */
+    {"CFS", READY_TREE, TRUE, fair_preempts, charge_vruntime} /* CFS */
+};
+static sched_policy_t *policy = &policies[FCFS]; /* the policy of the run */
+static int slice = 0;                /* ticks a dispatch may last under a sliced policy, 0 for no limit */
+
+/**
+ * A mailbox: a ring buffer of up to MAILBOX_CAPACITY messages and the
+ * processes blocked on it. A receiver blocks while the buffer is empty and a
+ * sender while it is full; the first of them is woken in O(1) by the send or
+ * receive that changes that.
+ */
+typedef struct mailbox_buf_t
+{
+    char *msgs[MAILBOX_CAPACITY]; /* the messages, the oldest at head */
+    int head;
+    int count;
+    pcb_queue_t receivers;        /* processes waiting for a message, FIFO */
+    pcb_queue_t senders;          /* processes waiting for room, FIFO */
+} mailbox_buf_t;
+
+static mailbox_buf_t *mailbox_bufs = NULL; /* mailbox id -> its buffer and blocked processes */
+static int num_mailbox_bufs = 0;
+
+/**
+ * The wait-for graph. A blocked process has one edge, to the process holding
+ * the resource it waits for, so the graph is stored as two maps that are
+ * updated in O(1) when a resource is acquired, released or waited for.
+ */
+static pcb_t **holders = NULL;       /* resource id -> process holding it */
+static int *waits_for = NULL;        /* process number -> resource id it waits for */
+static bool_t *deadlocked = NULL;    /* process number -> TRUE once found in a cycle */
+
+static victim_policy_t victim_policy = VICTIM_FEWEST_HELD;
+static pcb_t **cycle = NULL;         /* the last deadlock detected, not yet resolved */
+static int cycle_len = 0;
+static int *rollbacks = NULL;        /* process number -> times rolled back */
+static int num_deadlocks = 0;
+static int num_rolled_back = 0;      /* instructions undone by deadlock recovery */
+static unsigned long clock_tick = 0; /* logical clock: one tick per executed instruction */
+static int *avail = NULL;             /* resource id -> instances not held */
+static resource_t *alloc_nodes = NULL; /* one node per instance, recording it in a holder's list of resources */
+static resource_t **free_nodes = NULL; /* resource id -> its nodes not in any holder's list */
+static unsigned long *held_since = NULL; /* resource id -> tick at which the instances held last changed */
+static unsigned long *busy_ticks = NULL; /* resource id -> instance-ticks it has been held */
+static unsigned long context_switches = 0;
+static pcb_t *last_dispatched = NULL;
+
+/**
+ * A simulated CPU of the SMP mode. Each CPU has its own run queue: a FIFO
+ * for FCFS and RR, a heap ordered by priority for PRIOR, a tree ordered by
+ * virtual runtime for CFS.
+ */
+typedef struct cpu_t
+{
+    pcb_t *running;           /* process on the CPU, or NULL while idle */
+    int ticks_used;           /* ticks the running process has had since its dispatch */
+    pcb_queue_t queue;        /* run queue of the FCFS and RR schedulers */
+    pcb_heap_t heap;          /* run queue of the priority scheduler */
+    pcb_tree_t tree;          /* run queue of the completely fair scheduler */
+    int queued;               /* processes in the run queue */
+    pcb_t *last_run;          /* process dispatched last, to count context switches */
+    unsigned long busy_ticks; /* ticks spent running a process */
+    unsigned long steals;     /* processes taken from the run queues of other CPUs */
+} cpu_t;
+
+static int num_cpus = 1;
+static cpu_t *cpus = NULL;           /* the CPUs, while the SMP scheduler runs */
+
+/**
+ * The state of the Banker's algorithm (VICTIM_AVOID), as dense row-major
+ * matrices with one row per process number and one column per resource id,
+ * and a bitset of the processes holding an instance of any resource. Only
+ * those processes can stand in the way of a safe state.
+ */
+static int *max_claim = NULL;        /* process x resource -> most instances it may hold */
+static int *allocated = NULL;        /* process x resource -> instances it holds */
+static int *num_held = NULL;         /* process number -> instances it holds of all resources */
+static unsigned long *holding = NULL;  /* bitset of the process numbers holding an instance */
+static unsigned long *finished = NULL; /* bitset scratch of is_safe() */
+static int *work = NULL;             /* resource id -> scratch of is_safe() */
+static int bitset_words = 0;
+static pcb_queue_t unsafe_waitq;     /* processes whose request would have left an unsafe state */
+static pthread_mutex_t banker_lock = PTHREAD_MUTEX_INITIALIZER; /* the state above, while threads avoid deadlocks */
+
+/** A worker thread of the threaded backend, see schedule_threads() */
+typedef struct worker_t
+{
+    pthread_t thread;
+    pcb_t *last_run;           /* process dispatched last, to count context switches */
+    unsigned long dispatches;  /* processes taken from the ready queue */
+    unsigned long instrs;      /* instructions executed */
+} worker_t;
+
+static int num_threads = 0;          /* worker threads, 0 to simulate the CPUs instead */
+static bool_t threaded = FALSE;      /* TRUE while worker threads run the processes */
+static pthread_mutex_t *resource_locks = NULL; /* resource id -> lock of its holder, wait queue and counters,
+                                                  then one lock per mailbox */
+static pthread_mutex_t ready_lock = PTHREAD_MUTEX_INITIALIZER;   /* the ready and terminated queues */
+static pthread_cond_t work_ready = PTHREAD_COND_INITIALIZER;     /* a process was made ready or the run ended */
+static pthread_cond_t quiescent = PTHREAD_COND_INITIALIZER;      /* no process is running or ready */
+static pthread_mutex_t arrival_lock = PTHREAD_MUTEX_INITIALIZER; /* the arrivals heap */
+static long next_arrival = LONG_MAX;    /* arrival tick of the next process to arrive */
+static pcb_t *ready_first = NULL;    /* the best ready process of a heap or tree, read by running workers */
+static int busy_workers = 0;         /* workers running a process */
+static bool_t workers_done = FALSE;  /* set to make the idle workers exit */
+
+void run_events();
+event_t run_dispatch(pcb_t *proc);
+event_t run_tick(sched_policy_t *pol, pcb_t *proc, int *ticks_used, pcb_t **contender);
+void end_dispatch(pcb_t *proc, event_t event);
+void schedule_smp();
+void schedule_threads();
 bool_t higher_priority(int, int);
 
-void execute_instr(pcb_t *proc, instr_t *instr);
-void request_resource(pcb_t *proc, instr_t *instr);
-void release_resource(pcb_t *proc, instr_t *instr);
-bool_t acquire_resource(pcb_t *proc, char *resource_name);
+bool_t has_instrs(pcb_t *proc);
+bool_t execute_instr(pcb_t *proc);
+bool_t request_resource(pcb_t *proc, int resource_id);
+void release_resource(pcb_t *proc, int resource_id);
+bool_t acquire_resource(pcb_t *proc, resource_t *resource);
+void account_busy(int resource_id);
+bool_t send_message(pcb_t *proc, int mailbox_id, char *msg);
+void init_banker();
+void claim_program(pcb_t *pcb);
+bool_t grant_is_safe(pcb_t *pcb, int resource_id);
+bool_t is_safe(int number);
+void wake_unsafe_waiters();
+bool_t receive_message(pcb_t *proc, int mailbox_id);
 
 void check_for_new_arrivals();
-void move_proc_to_wq(pcb_t *pcb, char *resource_name);
-void move_waiting_pcbs_to_rq(char *resource_name);
+bool_t wait_for_arrival();
+pcb_t *next_ready();
+void dispatch(pcb_t *pcb, pcb_t **last_run);
+void order_ready(pcb_t *pcb, pcb_queue_t *queue, pcb_heap_t *heap, pcb_tree_t *tree);
+pcb_t *take_ordered(pcb_queue_t *queue, pcb_heap_t *heap, pcb_tree_t *tree);
+pcb_t *peek_ordered(pcb_queue_t *queue, pcb_heap_t *heap, pcb_tree_t *tree);
+void adopt_ready_order();
+void cpu_enqueue(cpu_t *cpu, pcb_t *pcb);
+pcb_t *cpu_dequeue(cpu_t *cpu);
+int least_loaded_cpu();
+pcb_t *steal_work(int thief);
+void *run_worker(void *arg);
+pcb_t *take_ready(worker_t *worker);
+void finish_dispatch();
+void wait_until_quiescent();
+bool_t resolve_blocked_procs();
+void admit_arrivals();
+unsigned long tick_now();
+unsigned long advance_clock();
+void lock_resource(int resource_id);
+void unlock_resource(int resource_id);
+void lock_banker();
+void unlock_banker();
+void lock_mailbox(int mailbox_id);
+void unlock_mailbox(int mailbox_id);
+pcb_t *detect_deadlock(pcb_t *pcb);
+void resolve_deadlock();
+pcb_t *choose_victim(pcb_t **procs, int num_procs);
+int count_held_resources(pcb_t *pcb);
+int count_progress(pcb_t *pcb);
+void report_blocked_procs();
+void report_run_metrics();
+void move_proc_to_wq(pcb_t *pcb, resource_t *resource);
+void move_waiting_pcbs_to_rq(resource_t *resource);
+void grant_waiter(pcb_t *pcb, resource_t *resource);
 void move_proc_to_rq(pcb_t *pcb);
 void move_proc_to_tq(pcb_t *pcb);
 void enqueue_pcb(pcb_t *proc, pcb_queue_t *queue);
+void enqueue_ready(pcb_t *pcb);
 pcb_t *dequeue_pcb(pcb_queue_t *queue);
+bool_t remove_pcb(pcb_t *pcb, pcb_queue_t *queue);
 
 char *get_init_data(int num_args, char **argv);
 char *get_data(int num_args, char **argv);
 int get_algo(int num_args, char **argv);
 int get_time_quantum(int num_args, char **argv);
+victim_policy_t get_victim_policy(int num_args, char **argv);
+int get_num_cpus(int num_args, char **argv);
+int get_num_threads();
 void print_args(char *data1, char *data2, int sched, int tq);
 
 void print_avail_resources(void);
 void print_alloc_resources(pcb_t *proc);
 void print_queue(pcb_queue_t queue, char *msg);
+void print_waiting_queues(char *msg);
+void print_ready_queue(char *msg);
 void print_running(pcb_t *proc, char *msg);
-void print_instructions(instr_t *instr);
+void print_instructions(process_in_mem_t *proc);
 
 int main(int argc, char **argv)
 {
+    if (argc > 1 && strcmp(argv[1], "batch") == 0)
+    {
+        return run_batch(argc, argv);
+    }
+
     char *data1 = get_init_data(argc, argv);
     char *data2 = get_data(argc, argv);
     scheduler = get_algo(argc, argv);
     int time_quantum = get_time_quantum(argc, argv);
     print_args(data1, data2, scheduler, time_quantum);
+    set_victim_policy(get_victim_policy(argc, argv));
+    set_num_cpus(get_num_cpus(argc, argv));
+    set_num_threads(get_num_threads());
+
+    begin_phase(PHASE_PARSE);
+    pcb_t *initial_procs = load_processes(data1, data2);
+
+    /* schedule the processes */
+    if (initial_procs)
+    {
+        run_processes(initial_procs, scheduler, time_quantum);
+    }
+    else
+    {
+        printf("Error: no processes to schedule\n");
+    }
+
+    return EXIT_SUCCESS;
+}
 
+/**
+ * @brief Generates the processes if <code>data1</code> is "generate", with
+ *        the generator settings in <code>data2</code>, or parses them from
+ *        the process files <code>data1</code> and <code>data2</code>.
+ *
+ * @return the linked list of initial processes, NULL if none could be loaded
+ */
+pcb_t *load_processes(char *data1, char *data2)
+{
     pcb_t *initial_procs = NULL;
+
     if (strcmp(data1, "generate") == 0)
     {
 #ifdef DEBUG_MNGR
         printf("****Generate processes and initialise the system\n");
 #endif
-        initial_procs = init_loader_from_generator();
+        if (configure_generator(data2))
+        {
+            initial_procs = init_loader_from_generator();
+        }
     }
     else
     {
@@ -78,22 +322,27 @@ int main(int argc, char **argv)
 #endif
         initial_procs = init_loader_from_files(data1, data2);
     }
+    return initial_procs;
+}
 
-    /* schedule the processes */
-    if (initial_procs)
-    {
-        num_processes = get_num_procs();
-        init_queues(initial_procs);
-        printf("***********Scheduling processes************\n");
-        schedule_processes(scheduler, time_quantum);
-        dealloc_data_structures();
-    }
-    else
-    {
-        printf("Error: no processes to schedule\n");
-    }
-
-    return EXIT_SUCCESS;
+/**
+ * @brief Builds the queues from the loaded processes, schedules them, then
+ *        frees the manager and the loaded processes and reports the time of
+ *        each phase.
+ */
+void run_processes(pcb_t *initial_procs, schedule_t sched_type, int quantum)
+{
+    scheduler = sched_type;
+    num_processes = get_num_procs();
+    begin_phase(PHASE_LOAD);
+    init_queues(initial_procs);
+    printf("***********Scheduling processes************\n");
+    begin_phase(PHASE_SCHEDULE);
+    schedule_processes(scheduler, quantum);
+    begin_phase(PHASE_TEARDOWN);
+    free_manager();
+    dealloc_data_structures();
+    report_phase_times();
 }
 
 /**
@@ -103,25 +352,114 @@ int main(int argc, char **argv)
  */
 void init_queues(pcb_t *cur_pcb)
 {
-    readyq.first = cur_pcb;
-    for (cur_pcb = readyq.first; cur_pcb->next != NULL; cur_pcb = cur_pcb->next)
-        ;
-    readyq.last = cur_pcb;
+    pcb_t *next;
+    long n;
+    int num_nodes = 0;
+
+    /*
+     * The initial processes are ready at tick 0 unless given a later arrival
+     * time. A process in the arrival list without one arrives at the tick
+     * equal to its position in the list, i.e. one per executed instruction.
+     */
+    init_pcb_heap(&arrivals);
+    readyq.first = readyq.last = NULL;
+    num_waitqs = get_num_resource_ids();
+    if (victim_policy == VICTIM_AVOID)
+    {
+        init_banker();
+    }
+    for (; cur_pcb != NULL; cur_pcb = next)
+    {
+        next = cur_pcb->next;
+        if (max_claim != NULL)
+        {
+            claim_program(cur_pcb);
+        }
+        if (cur_pcb->arrival == NO_ARRIVAL)
+        {
+            cur_pcb->arrival = 0;
+        }
+
+        if (cur_pcb->arrival > 0)
+        {
+            push_pcb_keyed(&arrivals, cur_pcb, -cur_pcb->arrival);
+        }
+        else
+        {
+            cur_pcb->ready_since = 0;
+            enqueue_pcb(cur_pcb, &readyq);
+        }
+    }
+    for (n = 1; (cur_pcb = get_new_pcb()) != NULL; n++)
+    {
+        if (max_claim != NULL)
+        {
+            claim_program(cur_pcb);
+        }
+        if (cur_pcb->arrival == NO_ARRIVAL)
+        {
+            cur_pcb->arrival = n;
+        }
+        push_pcb_keyed(&arrivals, cur_pcb, -cur_pcb->arrival);
+    }
     readyq_updated = FALSE;
 
-    waitingq.last = NULL;
-    waitingq.first = NULL;
+    /* one wait queue per resource id, all empty */
+    waitqs = calloc(num_waitqs > 0 ? num_waitqs : 1, sizeof(pcb_queue_t));
+
+    /* an empty wait-for graph */
+    holders = calloc(num_waitqs > 0 ? num_waitqs : 1, sizeof(pcb_t *));
+    waits_for = malloc((get_num_procs() + 1) * sizeof(int));
+    deadlocked = calloc(get_num_procs() + 1, sizeof(bool_t));
+    rollbacks = calloc(get_num_procs() + 1, sizeof(int));
+    cycle = malloc((get_num_procs() + 1) * sizeof(pcb_t *));
+    cycle_len = 0;
+    for (int i = 0; i <= get_num_procs(); i++)
+    {
+        waits_for[i] = NOT_WAITING;
+    }
     terminatedq.last = NULL;
     terminatedq.first = NULL;
 
+    /* metrics counters, see report_run_metrics() */
+    held_since = calloc(num_waitqs > 0 ? num_waitqs : 1, sizeof(unsigned long));
+    busy_ticks = calloc(num_waitqs > 0 ? num_waitqs : 1, sizeof(unsigned long));
+    context_switches = 0;
+
+    /* every instance of a resource is free, with its allocation node */
+    avail = calloc(num_waitqs > 0 ? num_waitqs : 1, sizeof(int));
+    free_nodes = calloc(num_waitqs > 0 ? num_waitqs : 1, sizeof(resource_t *));
+    for (int i = 0; i < num_waitqs; i++)
+    {
+        avail[i] = (get_resource(i) != NULL) ? get_resource(i)->instances : 0;
+        num_nodes += avail[i];
+    }
+    alloc_nodes = calloc(num_nodes > 0 ? num_nodes : 1, sizeof(resource_t));
+    for (int i = 0, node = 0; i < num_waitqs; i++)
+    {
+        for (int j = 0; j < avail[i]; j++, node++)
+        {
+            alloc_nodes[node].next = free_nodes[i];
+            free_nodes[i] = &alloc_nodes[node];
+        }
+    }
+
+    /* every mailbox named by an instruction starts empty */
+    num_mailbox_bufs = get_num_mailbox_ids();
+    mailbox_bufs = calloc(num_mailbox_bufs > 0 ? num_mailbox_bufs : 1, sizeof(mailbox_buf_t));
+    last_dispatched = NULL;
+
 #ifdef DEBUG_MNGR
-    printf("-----------------------------------");
-    print_queue(readyq, "Ready");
-    printf("\n-----------------------------------");
-    print_queue(waitingq, "Waiting");
-    printf("\n-----------------------------------");
-    print_queue(terminatedq, "Terminated");
-    printf("\n");
+    if (get_verbosity() >= VERBOSE_DEBUG)
+    {
+        printf("-----------------------------------");
+        print_queue(readyq, "Ready");
+        printf("\n-----------------------------------");
+        print_waiting_queues("Waiting");
+        printf("\n-----------------------------------");
+        print_queue(terminatedq, "Terminated");
+        printf("\n");
+    }
 #endif /* DEBUG_MNGR */
 }
 
@@ -129,551 +467,1956 @@ void init_queues(pcb_t *cur_pcb)
  * @brief Schedules each instruction of each process
  *
  * @param type The scheduling algorithm to use
- * @param quantum The time quantum for the RR algorithm, if used.
+ * @param quantum The time quantum of the sliced algorithms (RR, CFS), if used.
  */
 void schedule_processes(schedule_t sched_type, int quantum)
 {
-    printf("TODO: Implement two schedulers: a Priority based scheduler and either a Round Robin (RR) scheduler or a FCFS scheduler \n");
+    if (sched_type < PRIOR || sched_type > CFS)
+    {
+        report_blocked_procs();
+        report_run_metrics();
+        return;
+    }
+    policy = &policies[sched_type];
+    slice = !policy->sliced ? 0 : (quantum < 1) ? 1 : quantum;
+
+    /* admits the processes arriving at tick 0 */
+    check_for_new_arrivals();
+
+    if (num_threads > 0)
+    {
+        schedule_threads();
+    }
+    else if (num_cpus > 1)
+    {
+        schedule_smp();
+    }
+    else
+    {
+        run_events();
+    }
+
+    report_blocked_procs();
+    report_run_metrics();
+
+    if (num_deadlocks > 0 && victim_policy != VICTIM_NONE)
+    {
+        printf("Deadlocks resolved: %d, instructions rolled back: %d\n", num_deadlocks, num_rolled_back);
+    }
+}
+
+/**
+ * The discrete-event core that runs the processes on one CPU under any
+ * policy.
+ *
+ * The clock only moves through events. Executing an instruction takes one
+ * tick, and each dispatch lasts until one of the events of event_t ends it
+ * (run_dispatch()): completion, blocking, quantum expiry or preemption. The
+ * loop then files the process accordingly (end_dispatch()). Arrivals are the only events
+ * known ahead of time; they wait in the arrivals heap ordered by their tick.
+ * When no process is ready, the clock jumps to the next arrival in
+ * O(log n) (next_ready()) instead of stepping through the idle ticks.
+ *
+ * The policy orders the ready queue: a FIFO, a binary heap (readyh) by
+ * priority or a red-black tree (readyt) by virtual runtime, in which
+ * processes of equal priority or virtual runtime keep FIFO order.
+ */
+void run_events()
+{
+    pcb_t *proc;
+
+    adopt_ready_order();
+    while ((proc = next_ready()) != NULL)
+    {
+        end_dispatch(proc, run_dispatch(proc));
+    }
+
+    ready_order = READY_FIFO;
+    free_pcb_heap(&readyh);
+}
+
+/**
+ * Runs a dispatched process one tick at a time until an event ends the
+ * dispatch; a process made ready during the dispatch (last_ready) may
+ * preempt it.
+ *
+ * @return the event that ends the dispatch
+ */
+event_t run_dispatch(pcb_t *proc)
+{
+    int ticks_used = 0;
+    event_t event;
+
+    proc->state = RUNNING;
+    last_ready = NULL;
+    while ((event = run_tick(policy, proc, &ticks_used, &last_ready)) == EVENT_NONE);
+    return event;
+}
+
+/**
+ * The step of every backend: runs one tick of the dispatched process
+ * <code>proc</code> under policy <code>pol</code>. Executes its next
+ * instruction, which admits the arrivals of the tick (execute_instr()),
+ * advances its program counter, charges the tick to the policy and checks
+ * whether the dispatch is over.
+ *
+ * @param ticks_used Ticks the process has run in this dispatch, advanced by one.
+ * @param contender Where the best ready process is kept, which preempts
+ *     <code>proc</code> if the policy says so; NULL if the caller checks
+ *     for preemption itself. Read atomically, since a worker thread may
+ *     update it concurrently.
+ * @return EVENT_NONE if the process keeps the CPU, else the event that ends
+ *     the dispatch. A process without instructions left completes without
+ *     running a tick.
+ */
+event_t run_tick(sched_policy_t *pol, pcb_t *proc, int *ticks_used, pcb_t **contender)
+{
+    pcb_t *top;
+
+    if (!has_instrs(proc))
+    {
+        return EVENT_COMPLETION;
+    }
+    if (execute_instr(proc))
+    {
+        return EVENT_BLOCK;
+    }
+    proc->pc++;
+    (*ticks_used)++;
+    if (pol->charge != NULL)
+    {
+        pol->charge(proc);
+    }
+
+    if (!has_instrs(proc))
+    {
+        return EVENT_COMPLETION;
+    }
+    if (slice > 0 && *ticks_used >= slice)
+    {
+        return EVENT_QUANTUM_EXPIRY;
+    }
+    if (pol->preempts != NULL && contender != NULL
+        && (top = __atomic_load_n(contender, __ATOMIC_RELAXED)) != NULL && pol->preempts(top, proc))
+    {
+        return EVENT_PREEMPTION;
+    }
+    return EVENT_NONE;
+}
 
-    switch (sched_type)
+/**
+ * Files a process whose dispatch ended with <code>event</code>: a completed
+ * process terminates, a preempted one or one whose slice is used up goes
+ * back to the ready queue. A blocked process is already in a wait queue, so
+ * only deadlocks are looked for; the threaded backend does that on its main
+ * thread, and must not touch a blocked process, which another worker may
+ * already have woken.
+ */
+void end_dispatch(pcb_t *proc, event_t event)
+{
+    switch (event)
     {
-    case PRIOR:
-        schedule_pri_w_pre();
+    case EVENT_COMPLETION:
+        move_proc_to_tq(proc);
         break;
-    case RR:
-        schedule_rr(quantum);
+    case EVENT_BLOCK:
+        if (!threaded)
+        {
+            resolve_deadlock();
+        }
         break;
-    case FCFS:
-        schedule_fcfs();
+    case EVENT_QUANTUM_EXPIRY:
+    case EVENT_PREEMPTION:
+        move_proc_to_rq(proc);
         break;
     default:
         break;
     }
 }
 
-/** Schedules processes using priority scheduling with preemption */
-void schedule_pri_w_pre()
+/**
+ * @brief The preemption rule of the priority policy: a process preempts a
+ *        running process of lower priority
+ */
+bool_t outranks(pcb_t *ready, pcb_t *running)
+{
+    return higher_priority(ready->priority, running->priority);
+}
+
+/**
+ * @brief The preemption rule of the completely fair policy: a process
+ *        preempts a running process that is ahead of it in virtual runtime by
+ *        more than one tick of priority 0, so that a wakeup does not switch
+ *        the CPU back and forth between processes that are about even
+ */
+bool_t fair_preempts(pcb_t *ready, pcb_t *running)
+{
+    /* a worker charges its process while others compare against it */
+    return __atomic_load_n(&ready->vruntime, __ATOMIC_RELAXED) + CFS_TICK_VRUNTIME
+        < __atomic_load_n(&running->vruntime, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief The accounting of the completely fair policy: a tick adds to the
+ *        virtual runtime of the running process in inverse proportion to its
+ *        weight, priority + 1 (at least 1), so a process of priority p gets
+ *        p + 1 times the CPU time of a process of priority 0
+ */
+void charge_vruntime(pcb_t *running)
+{
+    unsigned long weight = (running->priority > 0) ? (unsigned long)running->priority + 1 : 1;
+
+    __atomic_store_n(&running->vruntime, running->vruntime + CFS_TICK_VRUNTIME / weight, __ATOMIC_RELAXED);
+}
+
+/**
+ * Schedules processes on num_cpus simulated CPUs (SMP mode).
+ *
+ * The CPUs run in lockstep: in every tick of the logical clock each CPU that
+ * has a process executes one of its instructions, in CPU order, so processes
+ * on different CPUs contend for the shared resources within a tick. Each CPU
+ * runs the policy on its own run queue: a sliced policy preempts a process
+ * after its slice, and a process queued on a CPU preempts the process
+ * running there if the policy says so. A process that is made ready joins
+ * the run queue of the CPU it last ran on, an arriving process joins the
+ * least loaded CPU, and a CPU whose run queue is empty steals the next
+ * process from the CPU with the most processes queued.
+ */
+void schedule_smp()
 {
-    while (readyq.first != NULL)
+    pcb_t *proc, *top;
+    cpu_t *cpu;
+    int c, busy;
+    event_t event;
+
+    cpus = calloc(num_cpus, sizeof(cpu_t));
+    for (c = 0; c < num_cpus; c++)
+    {
+        init_pcb_heap(&cpus[c].heap);
+        init_pcb_tree(&cpus[c].tree);
+    }
+    ready_order = policy->order;
+
+    /* deals the loaded processes out to the CPUs */
+    while ((proc = dequeue_pcb(&readyq)) != NULL)
     {
-        pcb_t *prev_proc = NULL, *proc_before_highest = NULL;
-        pcb_t *cur_proc = readyq.first, *high_pri_proc = readyq.first;
+        enqueue_ready(proc);
+    }
 
-        // finds the process in the ready queue with the highest priority
-        while (cur_proc != NULL)
+    for (;;)
+    {
+        /* every idle CPU dispatches the next process of its run queue, or steals one */
+        busy = 0;
+        for (c = 0; c < num_cpus; c++)
         {
-            switch (higher_priority(cur_proc->priority, high_pri_proc->priority))
+            cpu = &cpus[c];
+            if (cpu->running == NULL)
             {
-            case 1:
-                high_pri_proc = cur_proc;
-                proc_before_highest = prev_proc;
-                break;
-            case 0:
-            default:
-                break;
+                if ((proc = cpu_dequeue(cpu)) == NULL)
+                {
+                    proc = steal_work(c);
+                }
+                if (proc != NULL)
+                {
+                    dispatch(proc, &cpu->last_run);
+                    proc->state = RUNNING;
+                    cpu->running = proc;
+                    cpu->ticks_used = 0;
+                }
             }
-            prev_proc = cur_proc;
-            cur_proc = cur_proc->next;
+            busy += (cpu->running != NULL);
         }
 
-        if (high_pri_proc != NULL)
+        if (busy == 0)
         {
-            // removes the selected process from the ready queue
-            if (high_pri_proc == readyq.first)
-            {
-                readyq.first = high_pri_proc->next;
-            }
-            else
+            /* nothing to run on any CPU: skip to the next arrival, if any */
+            if (!wait_for_arrival())
             {
-                proc_before_highest->next = high_pri_proc->next;
+                break;
             }
+            continue;
+        }
 
-            if (high_pri_proc->next == NULL)
+        set_log_tick(++clock_tick);
+        for (c = 0; c < num_cpus; c++)
+        {
+            cpu = &cpus[c];
+            if ((proc = cpu->running) == NULL)
             {
-                readyq.last = proc_before_highest;
+                continue;
             }
 
-            // execute the process's instructions
-            while (high_pri_proc->next_instruction)
+            cpu->busy_ticks++;
+            if ((event = run_tick(policy, proc, &cpu->ticks_used, NULL)) != EVENT_NONE)
             {
-                execute_instr(high_pri_proc, high_pri_proc->next_instruction);
-
-                if (high_pri_proc->state == WAITING)
-                {
-                    break;
-                }
-
-                high_pri_proc->next_instruction = high_pri_proc->next_instruction->next;
-                check_for_new_arrivals();
-
-                // checks if the new process has a higher priority than the current highest priority
-                if (readyq.first && readyq.last->priority > high_pri_proc->priority)
-                {
-                    // if new process has higher priority it moves the current highest priority back into the ready queue
-                    move_proc_to_rq(high_pri_proc);
-                    high_pri_proc = readyq.last;
-                    break;
-                }
-
-                if (high_pri_proc->state == WAITING)
-                {
-                    break;
-                }
+                cpu->running = NULL;
+                end_dispatch(proc, event);
             }
+        }
+        check_for_new_arrivals();
 
-            // if all the process's instruction are executed - move process to termination queue
-            if (!high_pri_proc->next_instruction)
+        /* preempts the processes outranked by a process queued on their CPU,
+           once the arrivals of the tick have joined the run queues */
+        for (c = 0; policy->preempts != NULL && c < num_cpus; c++)
+        {
+            cpu = &cpus[c];
+            if (cpu->running != NULL && (top = peek_ordered(&cpu->queue, &cpu->heap, &cpu->tree)) != NULL
+                && policy->preempts(top, cpu->running))
             {
-                move_proc_to_tq(high_pri_proc);
+                proc = cpu->running;
+                cpu->running = NULL;
+                end_dispatch(proc, EVENT_PREEMPTION);
             }
         }
     }
+
+    for (c = 0; c < num_cpus; c++)
+    {
+        printf("CPU %d: busy %lu of %lu ticks, %lu processes stolen\n", c, cpus[c].busy_ticks, clock_tick, cpus[c].steals);
+        free_pcb_heap(&cpus[c].heap);
+    }
+    free(cpus);
+    cpus = NULL;
+    ready_order = READY_FIFO;
 }
 
-/** Schedules processes using FCFS scheduling */
-void schedule_fcfs()
+/** Adds <code>pcb</code> to the run queue of <code>cpu</code> */
+void cpu_enqueue(cpu_t *cpu, pcb_t *pcb)
 {
-    pcb_t *proc = readyq.first;
+    order_ready(pcb, &cpu->queue, &cpu->heap, &cpu->tree);
+    cpu->queued++;
+}
 
-    while (proc != NULL)
+/** Removes the next process from the run queue of <code>cpu</code>, or returns NULL */
+pcb_t *cpu_dequeue(cpu_t *cpu)
+{
+    pcb_t *pcb = take_ordered(&cpu->queue, &cpu->heap, &cpu->tree);
+
+    if (pcb != NULL)
     {
-        dequeue_pcb(&readyq);
+        cpu->queued--;
+    }
+    return pcb;
+}
 
-        for (instr_t *instr = proc->next_instruction; instr != NULL; instr = instr->next)
-        {
-            execute_instr(proc, instr);
+/** Returns the CPU with the fewest processes running or queued, the first one on ties */
+int least_loaded_cpu()
+{
+    int c, best = 0, load, best_load = INT_MAX;
 
-            /* Check for new arrivals */
-            check_for_new_arrivals();
+    for (c = 0; c < num_cpus; c++)
+    {
+        load = cpus[c].queued + (cpus[c].running != NULL);
+        if (load < best_load)
+        {
+            best = c;
+            best_load = load;
         }
-
-        move_proc_to_tq(proc);
-        proc = readyq.first;
     }
+    return best;
 }
 
 /**
- * Schedules processes using the Round-Robin scheduler.
+ * @brief Moves the next process of the CPU with the most processes queued to
+ * CPU <code>thief</code>
  *
- * @param[in] quantum time quantum
+ * @return the stolen process, or NULL if no other CPU has a process queued
  */
-void schedule_rr(int quantum)
+pcb_t *steal_work(int thief)
 {
-    /* TODO: Implement if chosen as 2nd option */
-    print_queue(readyq, "rr processes");
-}
+    int c, victim = -1;
+    pcb_t *pcb;
 
-/**
- * Executes a process instruction.
- *
- * @param[in] pcb
- *     processs for which to execute the instruction
- * @param[in] instr
- *     instruction to execute
- */
-void execute_instr(pcb_t *pcb, instr_t *instr)
-{
-    if (instr != NULL)
+    for (c = 0; c < num_cpus; c++)
     {
-        switch (instr->type)
+        if (c != thief && cpus[c].queued > 0 && (victim < 0 || cpus[c].queued > cpus[victim].queued))
         {
-        case REQ_OP:
-            request_resource(pcb, instr);
-            break;
-        case REL_OP:
-            release_resource(pcb, instr);
-            break;
-        default:
-            break;
+            victim = c;
         }
     }
-    else
+    if (victim < 0)
     {
-        printf("Error: No instruction to execute\n");
+        return NULL;
     }
 
-#ifdef DEBUG_MNGR
-    printf("-----------------------------------");
-    print_running(pcb, "Running");
-    printf("\n-----------------------------------");
-    print_queue(readyq, "Ready");
-    printf("\n-----------------------------------");
-    print_queue(waitingq, "Waiting");
-    printf("\n-----------------------------------");
-    print_queue(terminatedq, "Terminated");
-    printf("\n");
-#endif
+    pcb = cpu_dequeue(&cpus[victim]);
+    pcb->cpu = thief;
+    cpus[thief].steals++;
+    return pcb;
 }
 
 /**
- * @brief Handles the request resource instruction.
+ * Runs the processes on num_threads worker threads (the threaded backend).
  *
- * Executes the request instruction for the process. The function loops
- * through the list of resources and acquires the resource if it is available.
- * If the resource is not available the process is moved to the waiting queue
+ * Instead of simulating CPUs, each worker thread takes the next process from
+ * the shared ready queue and executes its instructions for real, so the
+ * manager's resource handling is exercised concurrently at hardware speed.
+ * Each resource has a mutex guarding its holder, its wait queue and its
+ * counters; the ready and terminated queues share one mutex, and idle
+ * workers sleep on a condition variable until a process is made ready.
+ * The policy orders the ready queue as usual: a sliced policy requeues a
+ * process after its slice, and a process is requeued as soon as the best
+ * ready process preempts it; otherwise it runs until it blocks or
+ * terminates. Every executed instruction still advances the logical clock
+ * by one tick, atomically.
  *
- * @param current The current process for which the resource must be acquired.
- * @param instruct The request instruction
+ * The main thread waits until no process is running or ready. It then looks
+ * for deadlocks among the blocked processes, resolving one if the victim
+ * policy allows, or else advances the clock to the next arrival. The run
+ * ends when neither makes a process ready.
  */
-void request_resource(pcb_t *cur_pcb, instr_t *instr)
+void schedule_threads()
 {
+    worker_t *workers = calloc(num_threads, sizeof(worker_t));
+    int w, started;
+
+    resource_locks = malloc((num_waitqs + num_mailbox_bufs + 1) * sizeof(pthread_mutex_t));
+    for (w = 0; w < num_waitqs + num_mailbox_bufs; w++)
+    {
+        pthread_mutex_init(&resource_locks[w], NULL);
+    }
 
-    resource_t *resources;
+    adopt_ready_order();
+    ready_first = (ready_order != READY_FIFO) ? peek_ordered(&readyq, &readyh, &readyt) : NULL;
+    busy_workers = 0;
+    workers_done = FALSE;
+    threaded = TRUE;
 
-    for (resources = get_available_resources(); resources != NULL; resources = resources->next)
+    get_verbosity(); /* reads SCHED_VERBOSITY before the workers do */
+    for (started = 0; started < num_threads; started++)
     {
-        //  If resource is available
-        if (strcmp(resources->name, instr->resource_name) == 0)
+        if (pthread_create(&workers[started].thread, NULL, run_worker, &workers[started]) != 0)
         {
-            //  If resource acquired
-            switch (acquire_resource(cur_pcb, resources->name))
-            {
-            case 1:
-            {
-                resource_t *resource = cur_pcb->resources;
-                resources->available = NO;
-
-                while (resource != NULL)
-                {
-                    resource = resource->next;
-                }
-                log_request_acquired(cur_pcb->process_in_mem->name, instr->resource_name);
-                return;
-            }
-            case 0:
-            {
-                cur_pcb->state = WAITING;
-                move_proc_to_wq(cur_pcb, instr->resource_name);
-                return;
-            }
-            }
+            fprintf(stderr, "Error: started only %d of %d worker threads\n", started, num_threads);
+            break;
         }
     }
-}
 
-/**
- * @brief Acquires a resource for a process.
- *
- * @param[in] process
- *     process for which to acquire the resource
- * @param[in] resource
- *     resource name
- * @return TRUE if the resource was successfully acquire_resource; FALSE otherwise
+    while (started > 0)
+    {
+        wait_until_quiescent();
+        if (resolve_blocked_procs())
+        {
+            continue;
+        }
+
+        pthread_mutex_lock(&arrival_lock);
+        w = wait_for_arrival();
+        pthread_mutex_unlock(&arrival_lock);
+        if (!w)
+        {
+            break;
+        }
+    }
+
+    pthread_mutex_lock(&ready_lock);
+    workers_done = TRUE;
+    pthread_cond_broadcast(&work_ready);
+    pthread_mutex_unlock(&ready_lock);
+    for (w = 0; w < started; w++)
+    {
+        pthread_join(workers[w].thread, NULL);
+        printf("Worker %d: %lu dispatches, %lu instructions\n", w, workers[w].dispatches, workers[w].instrs);
+    }
+
+    threaded = FALSE;
+    ready_order = READY_FIFO;
+    free_pcb_heap(&readyh);
+    for (w = 0; w < num_waitqs + num_mailbox_bufs; w++)
+    {
+        pthread_mutex_destroy(&resource_locks[w]);
+    }
+    free(resource_locks);
+    resource_locks = NULL;
+    free(workers);
+}
+
+/** The body of a worker thread of schedule_threads() */
+void *run_worker(void *arg)
+{
+    worker_t *worker = arg;
+    pcb_t *proc;
+    int ticks_used;
+    event_t event;
+
+    while ((proc = take_ready(worker)) != NULL)
+    {
+        proc->state = RUNNING;
+        ticks_used = 0;
+        while ((event = run_tick(policy, proc, &ticks_used, &ready_first)) == EVENT_NONE);
+
+        /* a blocking instruction was executed too */
+        worker->instrs += ticks_used + (event == EVENT_BLOCK);
+        end_dispatch(proc, event);
+        finish_dispatch();
+    }
+    return NULL;
+}
+
+/**
+ * @brief Waits until a process is ready, removes it from the ready queue and
+ * dispatches it on <code>worker</code>
+ *
+ * @return the process, or NULL once schedule_threads() ends the run
  */
-bool_t acquire_resource(pcb_t *cur_pcb, char *resource_name)
+pcb_t *take_ready(worker_t *worker)
+{
+    pcb_t *pcb;
+
+    pthread_mutex_lock(&ready_lock);
+    while ((pcb = take_ordered(&readyq, &readyh, &readyt)) == NULL && !workers_done)
+    {
+        pthread_cond_wait(&work_ready, &ready_lock);
+    }
+    if (pcb != NULL)
+    {
+        if (ready_order != READY_FIFO)
+        {
+            __atomic_store_n(&ready_first, peek_ordered(&readyq, &readyh, &readyt), __ATOMIC_RELAXED);
+        }
+        busy_workers++;
+        worker->dispatches++;
+        dispatch(pcb, &worker->last_run);
+    }
+    pthread_mutex_unlock(&ready_lock);
+    return pcb;
+}
+
+/** @brief Ends a dispatch, waking the main thread if no process is left to run */
+void finish_dispatch()
 {
-    resource_t *resource = get_available_resources();
+    pthread_mutex_lock(&ready_lock);
+    if (--busy_workers == 0 && peek_ordered(&readyq, &readyh, &readyt) == NULL)
+    {
+        pthread_cond_signal(&quiescent);
+    }
+    pthread_mutex_unlock(&ready_lock);
+}
 
-    while (resource != NULL)
+/** @brief Waits until no worker runs a process and no process is ready */
+void wait_until_quiescent()
+{
+    pthread_mutex_lock(&ready_lock);
+    while (busy_workers > 0 || peek_ordered(&readyq, &readyh, &readyt) != NULL)
     {
+        pthread_cond_wait(&quiescent, &ready_lock);
+    }
+    pthread_mutex_unlock(&ready_lock);
+}
+
+/**
+ * @brief Looks for deadlocks among the blocked processes while the workers
+ * are idle, and resolves the first one found unless the victim policy is
+ * VICTIM_NONE, in which case every deadlock is only logged.
+ *
+ * The wait-for path of a blocked process may lead into a cycle that it is
+ * not part of, so each path is followed until it reaches a process already
+ * visited; detect_deadlock() is then started from that process, which lies
+ * on the cycle if the process was visited on this same path. Every process
+ * is visited once.
+ *
+ * @return TRUE if a deadlock was resolved, so the processes can run again
+ */
+bool_t resolve_blocked_procs()
+{
+    int *visited = calloc(get_num_procs() + 1, sizeof(int)); /* process number -> path that visited it */
+    int path = 0, number;
+    bool_t resolved = FALSE;
+    pcb_t *proc, *cur;
 
-        // check if the name of the current resource matches the required resource name
-        if (strcmp(resource->name, resource_name) == 0)
+    for (int i = 0; i < num_waitqs && !resolved; i++)
+    {
+        for (proc = waitqs[i].first; proc != NULL && !resolved; proc = proc->next)
         {
-            /* If resource is available, assign it to the process */
-            if (resource->available == YES)
+            path++;
+            for (cur = proc; cur != NULL; cur = holders[waits_for[number]])
             {
+                number = cur->process_in_mem->number;
+                if (deadlocked[number] || (visited[number] != 0 && visited[number] != path))
+                {
+                    break;
+                }
+                if (visited[number] == path)
+                {
+                    if (detect_deadlock(cur) != NULL && victim_policy != VICTIM_NONE)
+                    {
+                        resolve_deadlock();
+                        resolved = TRUE;
+                    }
+                    break;
+                }
+                visited[number] = path;
+                if (waits_for[number] == NOT_WAITING)
+                {
+                    break;
+                }
+            }
+        }
+    }
+
+    free(visited);
+    return resolved;
+}
 
-                /* Add resource to the process's list of allocated resources */
-                resource_t *temp = (resource_t *)malloc(sizeof(resource_t));
-                temp->available = NO;
-                temp->name = resource_name;
-                temp->next = cur_pcb->resources;
-                cur_pcb->resources = temp;
+/**
+ * @brief Admits the processes that have arrived, from a worker thread. A
+ * worker that finds another one admitting them carries on instead of waiting.
+ */
+void admit_arrivals()
+{
+    if ((long)tick_now() >= __atomic_load_n(&next_arrival, __ATOMIC_RELAXED)
+        && pthread_mutex_trylock(&arrival_lock) == 0)
+    {
+        check_for_new_arrivals();
+        pthread_mutex_unlock(&arrival_lock);
+    }
+}
 
-                return 1;
-            }
+/** @brief Returns the logical clock, which worker threads read concurrently */
+unsigned long tick_now()
+{
+    return __atomic_load_n(&clock_tick, __ATOMIC_RELAXED);
+}
+
+/** @brief Advances the logical clock by one tick and returns the new tick */
+unsigned long advance_clock()
+{
+    return __atomic_add_fetch(&clock_tick, 1, __ATOMIC_RELAXED);
+}
+
+/** @brief Locks a resource in the threaded backend; does nothing otherwise */
+void lock_resource(int resource_id)
+{
+    if (max_claim != NULL)
+    {
+        /* the Banker's algorithm looks at all resources at once */
+        lock_banker();
+    }
+    else if (resource_locks != NULL)
+    {
+        pthread_mutex_lock(&resource_locks[resource_id]);
+    }
+}
+
+/** @brief Unlocks a resource locked by lock_resource() */
+void unlock_resource(int resource_id)
+{
+    if (max_claim != NULL)
+    {
+        unlock_banker();
+    }
+    else if (resource_locks != NULL)
+    {
+        pthread_mutex_unlock(&resource_locks[resource_id]);
+    }
+}
+
+/** @brief Locks the state of the Banker's algorithm in the threaded backend; does nothing otherwise */
+void lock_banker()
+{
+    if (resource_locks != NULL)
+    {
+        pthread_mutex_lock(&banker_lock);
+    }
+}
+
+/** @brief Unlocks the state of the Banker's algorithm locked by lock_banker() */
+void unlock_banker()
+{
+    if (resource_locks != NULL)
+    {
+        pthread_mutex_unlock(&banker_lock);
+    }
+}
+
+/** @brief Locks a mailbox in the threaded backend; does nothing otherwise */
+void lock_mailbox(int mailbox_id)
+{
+    if (resource_locks != NULL)
+    {
+        pthread_mutex_lock(&resource_locks[num_waitqs + mailbox_id]);
+    }
+}
+
+/** @brief Unlocks a mailbox locked by lock_mailbox() */
+void unlock_mailbox(int mailbox_id)
+{
+    if (resource_locks != NULL)
+    {
+        pthread_mutex_unlock(&resource_locks[num_waitqs + mailbox_id]);
+    }
+}
+
+/**
+ * @brief Returns TRUE if <code>pcb</code> has instructions left to execute
+ */
+bool_t has_instrs(pcb_t *pcb)
+{
+    return pcb->pc < pcb->process_in_mem->num_instrs;
+}
+
+/**
+ * Executes the process instruction at the process's program counter. The
+ * program counter is not advanced; that is up to the scheduler.
+ *
+ * @param[in] pcb
+ *     processs for which to execute the instruction
+ * @return TRUE if the process blocked. In the threaded backend the process
+ *     may already have been woken by another worker, so its state must not
+ *     be read instead.
+ */
+bool_t execute_instr(pcb_t *pcb)
+{
+    process_in_mem_t *proc = pcb->process_in_mem;
+    bool_t blocked = FALSE;
+
+    /* in SMP mode the CPUs share a tick, which schedule_smp() advances */
+    if (cpus == NULL)
+    {
+        set_log_tick(advance_clock());
+    }
+
+    if (has_instrs(pcb))
+    {
+        switch (proc->ops[pcb->pc])
+        {
+        case REQ_OP:
+            blocked = request_resource(pcb, proc->ids[pcb->pc]);
+            break;
+        case REL_OP:
+            release_resource(pcb, proc->ids[pcb->pc]);
+            break;
+        case SEND_OP:
+            blocked = send_message(pcb, proc->ids[pcb->pc], proc->msgs[pcb->pc]);
+            break;
+        case RECV_OP:
+            blocked = receive_message(pcb, proc->ids[pcb->pc]);
+            break;
+        default:
+            break;
         }
-        // move to next rsource in the available resources list
-        resource = resource->next;
     }
+    else
+    {
+        printf("Error: No instruction to execute\n");
+    }
+
+#ifdef DEBUG_MNGR
+    if (get_verbosity() >= VERBOSE_DEBUG && !threaded)
+    {
+        printf("-----------------------------------");
+        print_running(pcb, "Running");
+        printf("\n-----------------------------------");
+        print_ready_queue("Ready");
+        printf("\n-----------------------------------");
+        print_waiting_queues("Waiting");
+        printf("\n-----------------------------------");
+        print_queue(terminatedq, "Terminated");
+        printf("\n");
+    }
+#endif
+
+    if (threaded)
+    {
+        admit_arrivals();
+    }
+    else if (cpus == NULL)
+    {
+        check_for_new_arrivals();
+    }
+    return blocked;
+}
+
+/**
+ * @brief Handles the request resource instruction.
+ *
+ * Executes the request instruction for the process. The resource is looked
+ * up by its interned id and one of its instances is acquired if any is
+ * available. If none is available the process is moved to the waiting queue.
+ * With VICTIM_AVOID the process also waits, in unsafe_waitq, if granting the
+ * instance would leave a state that is not safe.
+ *
+ * @param current The current process for which the resource must be acquired.
+ * @param resource_id The id of the requested resource
+ * @return TRUE if the process was moved to the waiting queue
+ */
+bool_t request_resource(pcb_t *cur_pcb, int resource_id)
+{
+    resource_t *resource = get_resource(resource_id);
+    bool_t blocked = FALSE;
+
+    if (resource == NULL)
+    {
+        return FALSE;
+    }
+
+    lock_resource(resource_id);
+    //  If resource acquired
+    if (max_claim != NULL && avail[resource_id] > 0 && !grant_is_safe(cur_pcb, resource_id))
+    {
+        /* an instance is free, but granting it could lead to a deadlock */
+        cur_pcb->state = WAITING;
+        enqueue_pcb(cur_pcb, &unsafe_waitq);
+        log_request_waiting(cur_pcb->process_in_mem->name, resource->name);
+        blocked = TRUE;
+    }
+    else if (acquire_resource(cur_pcb, resource))
+    {
+        log_request_acquired(cur_pcb->process_in_mem->name, resource->name);
+    }
+    else
+    {
+        cur_pcb->state = WAITING;
+        move_proc_to_wq(cur_pcb, resource);
+        blocked = TRUE;
+    }
+    unlock_resource(resource_id);
+    return blocked;
+}
+
+/**
+ * @brief Acquires a resource for a process.
+ *
+ * @param[in] process
+ *     process for which to acquire the resource
+ * @param[in] resource
+ *     the global resource
+ * @return TRUE if the resource was successfully acquire_resource; FALSE otherwise
+ */
+bool_t acquire_resource(pcb_t *cur_pcb, resource_t *resource)
+{
+    resource_t *temp = NULL;
+    int id = resource->id, number = cur_pcb->process_in_mem->number;
+
+    if (avail[id] == 0)
+    {
+        return FALSE;
+    }
+
+    /* Add resource to the process's list of allocated resources, or count
+       another instance of it there */
+    if (resource->instances > 1)
+    {
+        for (temp = cur_pcb->resources; temp != NULL && temp->id != id; temp = temp->next);
+    }
+    if (temp == NULL)
+    {
+        temp = free_nodes[id];
+        free_nodes[id] = temp->next;
+        temp->available = NO;
+        temp->name = resource->name;
+        temp->id = id;
+        temp->instances = 0;
+        temp->next = cur_pcb->resources;
+        cur_pcb->resources = temp;
+    }
+    temp->instances++;
 
-    return 0;
+    account_busy(id);
+    if (--avail[id] == 0)
+    {
+        resource->available = NO;
+    }
+    /* the wait-for graph only has edges to the holder of a single instance */
+    if (resource->instances == 1)
+    {
+        holders[id] = cur_pcb;
+    }
+    if (max_claim != NULL)
+    {
+        allocated[number * num_waitqs + id]++;
+        if (num_held[number]++ == 0)
+        {
+            holding[number / WORD_BITS] |= 1UL << (number % WORD_BITS);
+        }
+    }
+    return TRUE;
 }
 
 /**
  * @brief Handles the release resource instruction.
  *
- * Executes the release instruction for the process. If the resource can be
+ * Executes the release instruction for the process, releasing one of the
+ * instances of the resource it holds. If the resource can be
  * released the process is ready for next execution. If the resource can not
  * be released the process waits
  *
- * @param current The process which releases the resource.
- * @param instruct The instruction to release the resource.
+ * @param current The process which releases the resource.
+ * @param resource_id The id of the resource to release.
+ */
+void release_resource(pcb_t *pcb, int resource_id)
+{
+    resource_t *resource = pcb->resources, *prev_resource = NULL;
+    int number;
+
+    /* Find the resource in the process's list of allocated resources */
+    for (; resource != NULL; prev_resource = resource, resource = resource->next)
+    {
+        if (resource->id == resource_id)
+        {
+            lock_resource(resource_id);
+
+            /* marks an instance of the resource as available */
+            account_busy(resource_id);
+            avail[resource_id]++;
+            get_resource(resource_id)->available = YES;
+            holders[resource_id] = NULL;
+            if (max_claim != NULL)
+            {
+                number = pcb->process_in_mem->number;
+                allocated[number * num_waitqs + resource_id]--;
+                if (--num_held[number] == 0)
+                {
+                    holding[number / WORD_BITS] &= ~(1UL << (number % WORD_BITS));
+                }
+            }
+
+            /* Remove resource from the process's list of resources once no instance is held */
+            if (--resource->instances == 0)
+            {
+                if (prev_resource != NULL)
+                {
+                    prev_resource->next = resource->next;
+                }
+                else
+                {
+                    pcb->resources = resource->next;
+                }
+                resource->next = free_nodes[resource_id];
+                free_nodes[resource_id] = resource;
+            }
+
+            /* Log successful release */
+            log_release_released(pcb->process_in_mem->name, get_resource_name(resource_id));
+            move_waiting_pcbs_to_rq(get_resource(resource_id));
+            if (max_claim != NULL)
+            {
+                /* the allocation changed, so a request refused as unsafe may pass now */
+                wake_unsafe_waiters();
+            }
+            unlock_resource(resource_id);
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Adds the instance-ticks resource <code>resource_id</code> was held
+ *        since the number of its instances held last changed to its busy time.
+ */
+void account_busy(int resource_id)
+{
+    unsigned long now = tick_now();
+
+    busy_ticks[resource_id] += (now - held_since[resource_id]) * (get_resource(resource_id)->instances - avail[resource_id]);
+    held_since[resource_id] = now;
+}
+
+/**
+ * @brief Allocates the state of the Banker's algorithm: no instance is
+ *        allocated and every claim is 0 until set by claim_program().
+ */
+void init_banker()
+{
+    int rows = get_num_procs() + 1, cols = num_waitqs > 0 ? num_waitqs : 1;
+
+    max_claim = calloc((size_t)rows * cols, sizeof(int));
+    allocated = calloc((size_t)rows * cols, sizeof(int));
+    num_held = calloc(rows, sizeof(int));
+    bitset_words = (rows + WORD_BITS - 1) / WORD_BITS;
+    holding = calloc(bitset_words, sizeof(unsigned long));
+    finished = calloc(bitset_words, sizeof(unsigned long));
+    work = calloc(cols, sizeof(int));
+    unsafe_waitq.first = unsafe_waitq.last = NULL;
+}
+
+/**
+ * @brief Sets the maximum claims of a process. A resource named in a claim
+ *        line gets that claim; any other resource gets the most instances the
+ *        program holds at once, found by replaying its requests and releases.
+ *        No claim exceeds the instances of the resource.
+ */
+void claim_program(pcb_t *pcb)
+{
+    process_in_mem_t *proc = pcb->process_in_mem;
+    int *claim = &max_claim[proc->number * num_waitqs];
+    int id;
+
+    memset(work, 0, num_waitqs * sizeof(int));
+    for (int i = 0; i < proc->num_instrs; i++)
+    {
+        id = proc->ids[i];
+        if (proc->ops[i] == REQ_OP && get_resource(id) != NULL)
+        {
+            if (++work[id] > claim[id])
+            {
+                claim[id] = work[id];
+            }
+        }
+        else if (proc->ops[i] == REL_OP && get_resource(id) != NULL && work[id] > 0)
+        {
+            work[id]--;
+        }
+    }
+    for (int i = 0; i < proc->num_claims; i++)
+    {
+        claim[proc->claim_ids[i]] = proc->claims[i];
+    }
+    for (id = 0; id < num_waitqs; id++)
+    {
+        if (get_resource(id) != NULL && claim[id] > get_resource(id)->instances)
+        {
+            claim[id] = get_resource(id)->instances;
+        }
+    }
+}
+
+/**
+ * @brief Returns TRUE if granting <code>pcb</code> an instance of resource
+ *        <code>resource_id</code>, which has one available, leaves a safe
+ *        state. A process requesting more than its claim has the claim raised.
+ *        If the process could then acquire all it may still need from the
+ *        available instances, it can finish and return them, which leaves the
+ *        state as safe as it was; only otherwise are all holders checked.
+ */
+bool_t grant_is_safe(pcb_t *pcb, int resource_id)
+{
+    int number = pcb->process_in_mem->number, row = number * num_waitqs;
+    bool_t raised = FALSE, safe = TRUE;
+
+    if (allocated[row + resource_id] + 1 > max_claim[row + resource_id])
+    {
+        max_claim[row + resource_id] = allocated[row + resource_id] + 1;
+        raised = TRUE;
+    }
+
+    /* tentatively grant the instance */
+    allocated[row + resource_id]++;
+    avail[resource_id]--;
+    for (int id = 0; id < num_waitqs; id++)
+    {
+        if (max_claim[row + id] - allocated[row + id] > avail[id])
+        {
+            safe = FALSE;
+            break;
+        }
+    }
+    if (!safe || raised)
+    {
+        safe = is_safe(number);
+    }
+    allocated[row + resource_id]--;
+    avail[resource_id]++;
+    return safe;
+}
+
+/**
+ * @brief The safety check of the Banker's algorithm: returns TRUE if the
+ *        processes holding instances, and the process <code>number</code>
+ *        making a request, can all finish in some order, each acquiring
+ *        what it may still need from the instances the earlier ones return.
+ */
+bool_t is_safe(int number)
+{
+    unsigned long word;
+    int p, w, id, *alloc_row, *claim_row;
+    bool_t progress = TRUE, all_finished = FALSE;
+
+    memcpy(work, avail, num_waitqs * sizeof(int));
+    memset(finished, 0, bitset_words * sizeof(unsigned long));
+    holding[number / WORD_BITS] |= 1UL << (number % WORD_BITS);
+    while (progress && !all_finished)
+    {
+        progress = FALSE;
+        all_finished = TRUE;
+        for (w = 0; w < bitset_words; w++)
+        {
+            for (word = holding[w] & ~finished[w]; word != 0; word &= word - 1)
+            {
+                p = w * WORD_BITS + __builtin_ctzl(word);
+                alloc_row = &allocated[p * num_waitqs];
+                claim_row = &max_claim[p * num_waitqs];
+                for (id = 0; id < num_waitqs && claim_row[id] - alloc_row[id] <= work[id]; id++);
+                if (id < num_waitqs)
+                {
+                    all_finished = FALSE;
+                    continue;
+                }
+
+                /* p can finish and return what it holds */
+                for (id = 0; id < num_waitqs; id++)
+                {
+                    work[id] += alloc_row[id];
+                }
+                finished[w] |= 1UL << (p - w * WORD_BITS);
+                progress = TRUE;
+            }
+        }
+    }
+    if (num_held[number] == 0)
+    {
+        holding[number / WORD_BITS] &= ~(1UL << (number % WORD_BITS));
+    }
+    return all_finished;
+}
+
+/**
+ * @brief Grants the processes whose request was refused as unsafe, in FIFO
+ *        order, the instance they requested if one is available and the
+ *        grant is safe now that the allocation has changed (grant_waiter()).
+ *        The others keep waiting in unsafe_waitq.
+ */
+void wake_unsafe_waiters()
+{
+    pcb_queue_t refused;
+    pcb_t *pcb;
+    int id;
+
+    refused.first = refused.last = NULL;
+    while ((pcb = dequeue_pcb(&unsafe_waitq)) != NULL)
+    {
+        id = pcb->process_in_mem->ids[pcb->pc];
+        if (avail[id] > 0 && grant_is_safe(pcb, id))
+        {
+            grant_waiter(pcb, get_resource(id));
+        }
+        else
+        {
+            enqueue_pcb(pcb, &refused);
+        }
+    }
+    unsafe_waitq = refused;
+}
+
+/**
+ * @brief Handles the send instruction.
+ *
+ * Appends <code>msg</code> to the mailbox and wakes the process that has
+ * waited longest for a message, if any. If the mailbox is full the process
+ * is moved to the mailbox's queue of senders instead, and retries the send
+ * when a receive makes room and wakes it.
+ *
+ * @return TRUE if the process was moved to the waiting queue
+ */
+bool_t send_message(pcb_t *pcb, int mailbox_id, char *msg)
+{
+    mailbox_buf_t *mailbox = &mailbox_bufs[mailbox_id];
+    pcb_t *receiver;
+    bool_t blocked = FALSE;
+
+    lock_mailbox(mailbox_id);
+    if (mailbox->count == MAILBOX_CAPACITY)
+    {
+        pcb->state = WAITING;
+        enqueue_pcb(pcb, &mailbox->senders);
+        log_send_waiting(pcb->process_in_mem->name, get_mailbox_name(mailbox_id));
+        blocked = TRUE;
+    }
+    else
+    {
+        mailbox->msgs[(mailbox->head + mailbox->count++) & (MAILBOX_CAPACITY - 1)] = msg;
+        log_send(pcb->process_in_mem->name, msg, get_mailbox_name(mailbox_id));
+        if ((receiver = dequeue_pcb(&mailbox->receivers)) != NULL)
+        {
+            move_proc_to_rq(receiver);
+        }
+    }
+    unlock_mailbox(mailbox_id);
+    return blocked;
+}
+
+/**
+ * @brief Handles the receive instruction.
+ *
+ * Takes the oldest message from the mailbox and wakes the process that has
+ * waited longest for room to send, if any. If the mailbox is empty the
+ * process is moved to the mailbox's queue of receivers instead, and retries
+ * the receive when a send wakes it.
+ *
+ * @return TRUE if the process was moved to the waiting queue
+ */
+bool_t receive_message(pcb_t *pcb, int mailbox_id)
+{
+    mailbox_buf_t *mailbox = &mailbox_bufs[mailbox_id];
+    pcb_t *sender;
+    char *msg;
+    bool_t blocked = FALSE;
+
+    lock_mailbox(mailbox_id);
+    if (mailbox->count == 0)
+    {
+        pcb->state = WAITING;
+        enqueue_pcb(pcb, &mailbox->receivers);
+        log_recv_waiting(pcb->process_in_mem->name, get_mailbox_name(mailbox_id));
+        blocked = TRUE;
+    }
+    else
+    {
+        msg = mailbox->msgs[mailbox->head];
+        mailbox->head = (mailbox->head + 1) & (MAILBOX_CAPACITY - 1);
+        mailbox->count--;
+        log_recv(pcb->process_in_mem->name, msg, get_mailbox_name(mailbox_id));
+        if ((sender = dequeue_pcb(&mailbox->senders)) != NULL)
+        {
+            move_proc_to_rq(sender);
+        }
+    }
+    unlock_mailbox(mailbox_id);
+    return blocked;
+}
+
+/**
+ * Adds the processes whose arrival time has been reached to the ready queue
+ */
+void check_for_new_arrivals()
+{
+    pcb_t *new_pcb;
+
+    while ((new_pcb = peek_pcb(&arrivals)) != NULL && new_pcb->arrival <= (long)tick_now())
+    {
+        pop_pcb(&arrivals);
+        if (get_verbosity() >= VERBOSE_EVENTS)
+        {
+            printf("New process arriving: %s\n", new_pcb->process_in_mem->name);
+        }
+        new_pcb->state = READY;
+        move_proc_to_rq(new_pcb);
+    }
+    __atomic_store_n(&next_arrival, new_pcb != NULL ? new_pcb->arrival : LONG_MAX, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Advances the clock to the next arrival and admits the processes
+ * arriving then. Used when no process is ready, so the CPU idles until then.
+ *
+ * @return FALSE if no process is left to arrive
+ */
+bool_t wait_for_arrival()
+{
+    pcb_t *next = peek_pcb(&arrivals);
+
+    if (next == NULL)
+    {
+        return FALSE;
+    }
+
+    if (next->arrival > (long)clock_tick)
+    {
+        clock_tick = next->arrival;
+        set_log_tick(clock_tick);
+    }
+    check_for_new_arrivals();
+    return TRUE;
+}
+
+/**
+ * @brief Removes the next process to dispatch from the ready queue, waiting
+ * for the next arrival if the ready queue is empty
+ *
+ * @return the process, or NULL once no process is ready or left to arrive
+ */
+pcb_t *next_ready()
+{
+    pcb_t *pcb = take_ordered(&readyq, &readyh, &readyt);
+
+    if (pcb == NULL && wait_for_arrival())
+    {
+        pcb = take_ordered(&readyq, &readyh, &readyt);
+    }
+
+    if (pcb != NULL)
+    {
+        dispatch(pcb, &last_dispatched);
+    }
+    return pcb;
+}
+
+/**
+ * @brief Records the dispatch of <code>pcb</code> for the metrics: the end of
+ * its wait in the ready queue, its first run, and a context switch if the CPU
+ * last ran another process (<code>*last_run</code>).
+ */
+void dispatch(pcb_t *pcb, pcb_t **last_run)
+{
+    unsigned long now = tick_now();
+
+    pcb->wait += now - pcb->ready_since;
+    if (ready_order == READY_TREE && pcb->vruntime > min_vruntime)
+    {
+        min_vruntime = pcb->vruntime;
+    }
+    if (pcb->first_run == NO_TICK)
+    {
+        pcb->first_run = now;
+    }
+    if (*last_run != NULL && pcb != *last_run)
+    {
+        context_switches++;
+    }
+    *last_run = pcb;
+}
+
+/**
+ * @brief Move process <code>pcb</code> to the ready queue
+ *
+ * @param[in] pcb
+ */
+void move_proc_to_rq(pcb_t *pcb)
+{
+    /* changes process state to READY */
+    pcb->state = READY;
+
+    /* moves process to the ready queue */
+    enqueue_ready(pcb);
+
+    log_request_ready(pcb->process_in_mem->name);
+}
+
+/**
+ * Move process <code>pcb</code> to the wait queue of <code>resource</code>
+ */
+void move_proc_to_wq(pcb_t *pcb, resource_t *resource)
+{
+    /* changes process state to WAITING */
+    pcb->state = WAITING;
+
+    /* move process to the wait queue of the resource */
+    enqueue_pcb(pcb, &waitqs[resource->id]);
+    waits_for[pcb->process_in_mem->number] = resource->id;
+
+    log_request_waiting(pcb->process_in_mem->name, resource->name);
+
+    /* the only new edge in the wait-for graph starts at pcb; the threaded
+       backend looks for deadlocks once its workers are idle instead */
+    if (!threaded)
+    {
+        detect_deadlock(pcb);
+    }
+}
+
+/**
+ * Move process <code>pcb</code> to terminated queue
+ *
+ * @param[in] pcb
+ */
+void move_proc_to_tq(pcb_t *pcb)
+{
+    /* the Banker's algorithm assumes a finishing process returns what it
+       holds; instances kept by a terminated process would break any safe
+       sequence that counted on them, and grant_is_safe() relies on the state
+       before a grant being safe, so they are released as by a rollback */
+    if (max_claim != NULL)
+    {
+        while (pcb->resources != NULL)
+        {
+            release_resource(pcb, pcb->resources->id);
+        }
+    }
+
+    /* changes process state to TERMINATED */
+    pcb->state = TERMINATED;
+    pcb->completion = tick_now();
+
+    /* move process to the terminated queue */
+    if (threaded)
+    {
+        pthread_mutex_lock(&ready_lock);
+        enqueue_pcb(pcb, &terminatedq);
+        pthread_mutex_unlock(&ready_lock);
+    }
+    else
+    {
+        enqueue_pcb(pcb, &terminatedq);
+    }
+
+    log_terminated(pcb->process_in_mem->name);
+}
+
+/**
+ * Wakes the processes that have waited longest for <code>resource</code>,
+ * one per available instance, by moving them from the resource's wait queue
+ * to the ready queue (grant_waiter()).
+ *
+ * Each woken process is handed an instance that was released, so a process
+ * that was ready in the meantime cannot take the instance first and send it
+ * back to the end of the wait queue. Waiters are thus served in FIFO order.
+ * With VICTIM_AVOID a waiter whose grant would not be safe is moved to
+ * unsafe_waitq instead, and the next waiter is considered.
+ *
+ * @param[in]   resource
+ *     the resource that was released
+ */
+void move_waiting_pcbs_to_rq(resource_t *resource)
+{
+    pcb_t *current;
+
+    while (avail[resource->id] > 0 && (current = dequeue_pcb(&waitqs[resource->id])) != NULL)
+    {
+        waits_for[current->process_in_mem->number] = NOT_WAITING;
+        if (max_claim != NULL && !grant_is_safe(current, resource->id))
+        {
+            enqueue_pcb(current, &unsafe_waitq);
+            continue;
+        }
+        grant_waiter(current, resource);
+    }
+}
+
+/**
+ * Hands process <code>pcb</code>, waiting for <code>resource</code>, an
+ * instance of it: the process acquires the instance and moves past its
+ * request, then is made ready.
+ */
+void grant_waiter(pcb_t *pcb, resource_t *resource)
+{
+    acquire_resource(pcb, resource);
+    log_request_acquired(pcb->process_in_mem->name, resource->name);
+    pcb->pc++;
+
+    // Set the state of the process to READY
+    pcb->state = READY;
+
+    // enqueue the process into the ready queue
+    enqueue_ready(pcb);
+    log_request_ready(pcb->process_in_mem->name);
+}
+
+/**
+ * Enqueues process <code>pcb</code> to <code>queue</code>.
+ *
+ * @param[in] process
+ *     process to enqueue
+ * @param[in] queue
+ *     queue to which the process must be enqueued
+ */
+void enqueue_pcb(pcb_t *pcb, pcb_queue_t *queue)
+{
+    // Check if queue is empty
+    if (queue->first == NULL)
+    {
+        // If the queue is empty, set first process to new pcb
+        queue->first = pcb;
+    }
+    else
+    {
+        queue->last->next = pcb;
+    }
+
+    // set last node of queue to pcb
+    queue->last = pcb;
+    pcb->next = NULL;
+}
+
+/**
+ * Adds process <code>pcb</code> to the ready queue of the running scheduler.
+ *
+ * @param[in] pcb
+ *     process to make ready
+ */
+void enqueue_ready(pcb_t *pcb)
+{
+    if (threaded)
+    {
+        pthread_mutex_lock(&ready_lock);
+    }
+    pcb->ready_since = tick_now();
+
+    if (cpus != NULL)
+    {
+        if (pcb->cpu == NO_CPU)
+        {
+            pcb->cpu = least_loaded_cpu();
+        }
+        cpu_enqueue(&cpus[pcb->cpu], pcb);
+    }
+    else
+    {
+        order_ready(pcb, &readyq, &readyh, &readyt);
+    }
+    last_ready = pcb;
+
+    if (threaded)
+    {
+        if (ready_order != READY_FIFO)
+        {
+            __atomic_store_n(&ready_first, peek_ordered(&readyq, &readyh, &readyt), __ATOMIC_RELAXED);
+        }
+        pthread_cond_signal(&work_ready);
+        pthread_mutex_unlock(&ready_lock);
+    }
+}
+
+/**
+ * @brief Adds <code>pcb</code> to the ready queue of the order in use: the
+ *        FIFO <code>queue</code>, the <code>heap</code> or the <code>tree</code>.
+ *
+ * In the tree, a process that has not run for a while (an arrival or a woken
+ * process) starts at min_vruntime, so it does not get the CPU to itself
+ * until it has caught up with the processes that kept running.
+ */
+void order_ready(pcb_t *pcb, pcb_queue_t *queue, pcb_heap_t *heap, pcb_tree_t *tree)
+{
+    switch (ready_order)
+    {
+    case READY_FIFO:
+        enqueue_pcb(pcb, queue);
+        break;
+    case READY_HEAP:
+        push_pcb(heap, pcb);
+        break;
+    case READY_TREE:
+        if (pcb->vruntime < min_vruntime)
+        {
+            __atomic_store_n(&pcb->vruntime, min_vruntime, __ATOMIC_RELAXED);
+        }
+        insert_pcb_tree(tree, pcb);
+        break;
+    }
+}
+
+/** @brief Removes the next process from the ready queue of the order in use, or returns NULL */
+pcb_t *take_ordered(pcb_queue_t *queue, pcb_heap_t *heap, pcb_tree_t *tree)
+{
+    switch (ready_order)
+    {
+    case READY_HEAP:
+        return pop_pcb(heap);
+    case READY_TREE:
+        return pop_leftmost_pcb(tree);
+    default:
+        return dequeue_pcb(queue);
+    }
+}
+
+/** @brief Returns the next process of the ready queue of the order in use without removing it, or NULL */
+pcb_t *peek_ordered(pcb_queue_t *queue, pcb_heap_t *heap, pcb_tree_t *tree)
+{
+    switch (ready_order)
+    {
+    case READY_HEAP:
+        return peek_pcb(heap);
+    case READY_TREE:
+        return peek_leftmost_pcb(tree);
+    default:
+        return queue->first;
+    }
+}
+
+/**
+ * @brief Orders the ready queue as the policy of the run says, moving the
+ *        loaded processes from readyq into readyh or readyt
+ */
+void adopt_ready_order()
+{
+    pcb_t *proc;
+
+    init_pcb_heap(&readyh);
+    init_pcb_tree(&readyt);
+    min_vruntime = 0;
+    ready_order = policy->order;
+    while (ready_order != READY_FIFO && (proc = dequeue_pcb(&readyq)) != NULL)
+    {
+        order_ready(proc, &readyq, &readyh, &readyt);
+    }
+}
+
+/**
+ * Dequeues a process from queue <code>queue</code>.
+ *
+ * @param[in] queue
+ *     queue from which to dequeue a process
+ * @return dequeued process
+ */
+pcb_t *dequeue_pcb(pcb_queue_t *queue)
+{
+    pcb_t *deq;
+
+    if (queue->first == NULL)
+    {
+        return NULL;
+    }
+
+    /* Setting the next process in the list as the first process */
+    deq = queue->first;
+    queue->first = queue->first->next;
+    deq->next = NULL;
+
+    /* checking if the queue is empty*/
+    if (queue->first == NULL)
+    {
+        queue->last = NULL;
+    }
+
+    return deq;
+}
+
+/**
+ * Removes process <code>pcb</code> from anywhere in <code>queue</code>.
+ *
+ * @return TRUE if the process was found in the queue
  */
-void release_resource(pcb_t *pcb, instr_t *instr)
+bool_t remove_pcb(pcb_t *pcb, pcb_queue_t *queue)
 {
+    pcb_t *prev = NULL, *cur;
 
-    resource_t *resource = pcb->resources, *prev_resource = NULL;
-
-    /* Find the resource in the process's list of allocated resources */
-    for (; resource != NULL; resource = resource->next)
+    for (cur = queue->first; cur != NULL; prev = cur, cur = cur->next)
     {
-        /* Resource needed is found */
-        if (strcmp(resource->name, instr->resource_name) == 0)
+        if (cur == pcb)
         {
-            if (resource != NULL)
+            if (prev == NULL)
             {
-                /* marks resource as available */
-                resource_t *global_resource = get_available_resources();
-
-                for (; strcmp(global_resource->name, resource->name) != 0; global_resource = global_resource->next)
-                    ;
-
-                global_resource->available = YES;
-                resource->available = YES;
-
-                /* Remove resource from the process's list of resources */
-                if (prev_resource != NULL)
-                {
-                    prev_resource->next = resource->next;
-                }
-                else
-                {
-                    pcb->resources = resource->next;
-                }
-
-                /* Log successful release */
-                log_release_released(pcb->process_in_mem->name, instr->resource_name);
-                move_waiting_pcbs_to_rq(resource->name);
-                return;
+                queue->first = cur->next;
             }
             else
             {
-                /* Resource not assigned to process, log release error */
-                log_release_error(pcb->process_in_mem->name, instr->resource_name);
-                return;
+                prev->next = cur->next;
+            }
+            if (queue->last == cur)
+            {
+                queue->last = prev;
             }
+            cur->next = NULL;
+            return TRUE;
         }
-
-        prev_resource = resource;
     }
+    return FALSE;
 }
 
-/**
- * Add new process <code>pcb</code> to ready queue
+/** @brief Return TRUE if pri1 has a higher priority than pri2
+ *         where higher values == higher priorities
+ *
+ * @param[in] pri1
+ *     priority value 1
+ * @param[in] pri2
+ *     priority value 2
  */
-void check_for_new_arrivals()
+bool_t higher_priority(int pri1, int pri2)
 {
 
-    pcb_t *new_pcb = get_new_pcb();
-
-    if (new_pcb)
+    if (pri1 <= pri2)
     {
-        printf("New process arriving: %s\n", new_pcb->process_in_mem->name);
-        new_pcb->state = READY;
-        move_proc_to_rq(new_pcb);
+        return FALSE;
     }
+
+    return TRUE;
 }
 
 /**
- * @brief Move process <code>pcb</code> to the ready queue
+ * @brief Detects a deadlock closed by <code>pcb</code> starting to wait.
  *
- * @param[in] pcb
+ * Follows the wait-for graph from pcb: to the holder of the resource pcb
+ * waits for, to the holder of the resource that process waits for, and so
+ * on. If the path leads back to pcb the processes on it are deadlocked and
+ * are logged. Only the path from pcb is visited, so the cost is linear in
+ * the number of edges affected by the new wait.
+ *
+ * @param pcb The process that has just been moved to a wait queue.
+ * @return pcb if it is part of a deadlock, NULL otherwise
  */
-void move_proc_to_rq(pcb_t *pcb)
+struct pcb_t *detect_deadlock(pcb_t *pcb)
 {
-    /* changes process state to READY */
-    pcb->state = READY;
+    pcb_t *cur = pcb;
+    char **names;
 
-    /* moves process to the ready queue */
-    enqueue_pcb(pcb, &readyq);
+    while (waits_for[cur->process_in_mem->number] != NOT_WAITING)
+    {
+        cur = holders[waits_for[cur->process_in_mem->number]];
 
-    log_request_ready(pcb->process_in_mem->name);
-}
+        /* the path ends at a running process or joins a known deadlock */
+        if (cur == NULL || deadlocked[cur->process_in_mem->number])
+        {
+            return NULL;
+        }
+        if (cur == pcb)
+        {
+            break;
+        }
+    }
+    if (cur != pcb)
+    {
+        return NULL;
+    }
 
-/**
- * Move process <code>pcb</code> to waiting queue
- */
-void move_proc_to_wq(pcb_t *pcb, char *resource_name)
-{
-    /* changes process state to WAITING */
-    pcb->state = WAITING;
+    // if deadlock detected, remember the cycle for resolve_deadlock()
+    names = malloc(get_num_procs() * sizeof(char *));
+    cycle_len = 0;
+    do
+    {
+        deadlocked[cur->process_in_mem->number] = TRUE;
+        names[cycle_len] = cur->process_in_mem->name;
+        cycle[cycle_len++] = cur;
+        cur = holders[waits_for[cur->process_in_mem->number]];
+    } while (cur != pcb);
 
-    /* move process to the waiting queue */
-    enqueue_pcb(pcb, &waitingq);
+    log_deadlock_detected(names, cycle_len);
+    free(names);
+    num_deadlocks++;
 
-    log_request_waiting(pcb->process_in_mem->name, resource_name);
+    return pcb;
 }
 
 /**
- * Move process <code>pcb</code> to terminated queue
- *
- * @param[in] pcb
+ * @brief Logs the processes left waiting at the end of scheduling that are
+ *        not part of a deadlock, e.g. those waiting for a resource held by a
+ *        terminated process or for a message that is never sent.
  */
-void move_proc_to_tq(pcb_t *pcb)
+void report_blocked_procs()
 {
-    /* changes process state to TERMINATED */
-    pcb->state = TERMINATED;
+    char **blocked = malloc((get_num_procs() + 1) * sizeof(char *));
+    int num_blocked = 0;
+    pcb_t *proc;
 
-    /* move process to the terminated queue */
-    enqueue_pcb(pcb, &terminatedq);
+    for (int i = 0; i < num_waitqs; i++)
+    {
+        for (proc = waitqs[i].first; proc != NULL; proc = proc->next)
+        {
+            if (!deadlocked[proc->process_in_mem->number])
+            {
+                blocked[num_blocked++] = proc->process_in_mem->name;
+            }
+        }
+    }
+    for (int i = 0; i < num_mailbox_bufs; i++)
+    {
+        for (proc = mailbox_bufs[i].receivers.first; proc != NULL; proc = proc->next)
+        {
+            blocked[num_blocked++] = proc->process_in_mem->name;
+        }
+        for (proc = mailbox_bufs[i].senders.first; proc != NULL; proc = proc->next)
+        {
+            blocked[num_blocked++] = proc->process_in_mem->name;
+        }
+    }
+    for (proc = unsafe_waitq.first; proc != NULL; proc = proc->next)
+    {
+        blocked[num_blocked++] = proc->process_in_mem->name;
+    }
 
-    log_terminated(pcb->process_in_mem->name);
+    if (num_blocked > 0)
+    {
+        log_blocked_procs(blocked, num_blocked);
+    }
+    free(blocked);
 }
 
 /**
- * Moves all processes waiting for resource <code>resource_name</code>
- * from the waiting queue to the readyq queue.
- *
- * @param[in]   resource
- *     resource name
+ * @brief Reports the timing statistics of the run (see metrics.h). Resources
+ *        still held at the end count as busy until the last tick.
  */
-void move_waiting_pcbs_to_rq(char *resource_name)
+void report_run_metrics()
 {
-    pcb_t *current = waitingq.first;
+    run_stats_t stats;
 
-    // iterate over every node
-    while (current != NULL)
+    for (int i = 0; i < num_waitqs; i++)
     {
-        char *required_resource = current->next_instruction->resource_name;
-
-        resource_t *avail_resource = get_available_resources();
-
-        // iterate over every resource in the get_available_resources() list
-        while (avail_resource != NULL)
+        if (get_resource(i) != NULL)
         {
-            if (strcmp(required_resource, avail_resource->name) == 0 && avail_resource->available == YES)
-            {
-                // Set the state of the current process to READY
-                current->state = READY;
-
-                // enqueue the current process into the ready queue
-                enqueue_pcb(current, &readyq);
-
-                // dequeue the current process from the waiting queue
-                dequeue_pcb(&waitingq);
-                log_request_ready(current->process_in_mem->name);
-                return;
-            }
-
-            avail_resource = avail_resource->next;
+            account_busy(i);
         }
-        // move the current process into the waiting queue
-        current = current->next;
     }
+
+    stats.scheduler = policy->name;
+    stats.num_procs = num_processes;
+    stats.ticks = clock_tick;
+    stats.context_switches = context_switches;
+    stats.num_resources = num_waitqs;
+    stats.busy_ticks = busy_ticks;
+    report_metrics(&stats, terminatedq.first);
 }
 
 /**
- * Enqueues process <code>pcb</code> to <code>queue</code>.
+ * @brief Releases a processes' resources and sets it to its first instruction.
  *
- * @param[in] process
- *     process to enqueue
- * @param[in] queue
- *     queue to which the process must be enqueued
+ * Chooses a victim from the last deadlock detected, using the victim policy.
+ * Releases each of the processes' resources as if it had executed a release
+ * instruction, which wakes the processes waiting for them. The victim is then
+ * rewound to its first instruction, by resetting its program counter, and
+ * made ready. A victim
+ * that was already rolled back MAX_ROLLBACKS times, e.g. one that requests a
+ * resource it holds, is terminated instead so that recovery cannot livelock.
+ *
+ * Does nothing if there is no unresolved deadlock or the policy is VICTIM_NONE.
  */
-void enqueue_pcb(pcb_t *pcb, pcb_queue_t *queue)
+void resolve_deadlock()
 {
-    // Check if queue is empty
-    if (queue->first == NULL)
+    pcb_t *victim;
+    int i, number;
+
+    if (cycle_len == 0 || victim_policy == VICTIM_NONE)
     {
-        // If the queue is empty, set first process to new pcb
-        queue->first = pcb;
+        return;
     }
-    else
+
+    victim = choose_victim(cycle, cycle_len);
+    for (i = 0; i < cycle_len; i++)
     {
-        queue->last->next = pcb;
+        deadlocked[cycle[i]->process_in_mem->number] = FALSE;
     }
+    cycle_len = 0;
 
-    // set last node of queue to pcb
-    queue->last = pcb;
-    pcb->next = NULL;
+    /* take the victim off the wait queue of the resource it waits for */
+    number = victim->process_in_mem->number;
+    remove_pcb(victim, &waitqs[waits_for[number]]);
+    waits_for[number] = NOT_WAITING;
+
+    /* release all the victim's resources */
+    while (victim->resources != NULL)
+    {
+        release_resource(victim, victim->resources->id);
+    }
+
+    num_rolled_back += count_progress(victim);
+    if (++rollbacks[number] > MAX_ROLLBACKS)
+    {
+        victim->pc = victim->process_in_mem->num_instrs;
+        move_proc_to_tq(victim);
+        return;
+    }
+
+    victim->pc = 0;
+    move_proc_to_rq(victim);
 }
 
 /**
- * Dequeues a process from queue <code>queue</code>.
- *
- * @param[in] queue
- *     queue from which to dequeue a process
- * @return dequeued process
+ * @brief Chooses the process to roll back, following the victim policy.
+ *        Ties are broken in favour of the first process in <code>procs</code>.
  */
-pcb_t *dequeue_pcb(pcb_queue_t *queue)
+pcb_t *choose_victim(pcb_t **procs, int num_procs)
 {
-    pcb_t *deq;
+    pcb_t *victim = procs[0];
+    int cost, victim_cost = 0;
 
-    if (queue->first == NULL)
+    for (int i = 0; i < num_procs; i++)
     {
-        return NULL;
-    }
-
-    /* Setting the next process in the list as the first process */
-    deq = queue->first;
-    queue->first = queue->first->next;
-    deq->next = NULL;
+        switch (victim_policy)
+        {
+        case VICTIM_LOWEST_PRIORITY:
+            cost = procs[i]->priority;
+            break;
+        case VICTIM_LEAST_PROGRESS:
+            cost = count_progress(procs[i]);
+            break;
+        case VICTIM_FEWEST_HELD:
+        default:
+            cost = count_held_resources(procs[i]);
+            break;
+        }
 
-    /* checking if the queue is empty*/
-    if (queue->first == NULL)
-    {
-        queue->last = NULL;
+        if (i == 0 || cost < victim_cost)
+        {
+            victim = procs[i];
+            victim_cost = cost;
+        }
     }
 
-    return deq;
+    return victim;
 }
 
-/** @brief Return TRUE if pri1 has a higher priority than pri2
- *         where higher values == higher priorities
- *
- * @param[in] pri1
- *     priority value 1
- * @param[in] pri2
- *     priority value 2
+/**
+ * @brief Returns the number of resource instances allocated to <code>pcb</code>
  */
-bool_t higher_priority(int pri1, int pri2)
+int count_held_resources(pcb_t *pcb)
 {
+    int held = 0;
 
-    if (pri1 <= pri2)
+    for (resource_t *resource = pcb->resources; resource != NULL; resource = resource->next)
     {
-        return FALSE;
+        held += resource->instances;
     }
-
-    return TRUE;
+    return held;
 }
 
 /**
- * @brief Inspect the waiting queue and detects deadlock
+ * @brief Returns the number of instructions <code>pcb</code> has completed
  */
-struct pcb_t *detect_deadlock()
+int count_progress(pcb_t *pcb)
 {
-    //  printf("Function detect_deadlock not implemented\n");
+    return pcb->pc;
+}
 
-    // if deadlock detected
-    // log_deadlock_detected();
+/**
+ * @brief Sets the deadlock victim selection policy
+ */
+void set_victim_policy(victim_policy_t policy)
+{
+    victim_policy = policy;
+}
 
-    return NULL;
+/**
+ * @brief Sets the number of simulated CPUs
+ */
+void set_num_cpus(int count)
+{
+    num_cpus = (count > 1) ? count : 1;
 }
 
 /**
- * @brief Releases a processes' resources and sets it to its first instruction.
- *
- * Generates release instructions for each of the processes' resoures and forces
- * it to execute those instructions.
- *
- * @param pcb The process chosen to be reset and release all of its resources.
- *
+ * @brief Sets the number of worker threads of the threaded backend
  */
-void resolve_deadlock()
+void set_num_threads(int count)
 {
-    /* TODO: Implement */
-    printf("Function resolve_deadlock not implemented\n");
+    num_threads = (count > 0) ? count : 0;
 }
 
 /**
  * @brief Deallocates the queues
+ *
+ * The pcbs in the queues, and the allocation nodes of their resources, belong
+ * to the loader and are freed by dealloc_data_structures().
  */
 void free_manager(void)
 {
 #ifdef DEBUG_MNGR
-    print_queue(readyq, "Ready");
-    print_queue(waitingq, "Waiting");
-    print_queue(terminatedq, "Terminated");
-#endif
-
-#ifdef DEBUG_MNGR
-    printf("\nFreeing the queues...\n");
+    if (get_verbosity() >= VERBOSE_DEBUG)
+    {
+        print_queue(readyq, "Ready");
+        print_waiting_queues("Waiting");
+        print_queue(terminatedq, "Terminated");
+        printf("\nFreeing the queues...\n");
+    }
 #endif
-    dealloc_pcb_list(readyq.first);
-    dealloc_pcb_list(waitingq.first);
-    dealloc_pcb_list(terminatedq.first);
+    readyq.first = readyq.last = NULL;
+    terminatedq.first = terminatedq.last = NULL;
+    free(waitqs);
+    waitqs = NULL;
+    num_waitqs = 0;
+    free(holders);
+    free(held_since);
+    free(busy_ticks);
+    held_since = NULL;
+    busy_ticks = NULL;
+    free(waits_for);
+    free(deadlocked);
+    free(rollbacks);
+    free(cycle);
+    rollbacks = NULL;
+    cycle = NULL;
+    holders = NULL;
+    waits_for = NULL;
+    deadlocked = NULL;
+    free(alloc_nodes);
+    free(free_nodes);
+    free(avail);
+    alloc_nodes = NULL;
+    free_nodes = NULL;
+    avail = NULL;
+    free(max_claim);
+    free(allocated);
+    free(num_held);
+    free(holding);
+    free(finished);
+    free(work);
+    max_claim = NULL;
+    allocated = NULL;
+    num_held = NULL;
+    holding = NULL;
+    finished = NULL;
+    work = NULL;
+    bitset_words = 0;
+    free(mailbox_bufs);
+    mailbox_bufs = NULL;
+    num_mailbox_bufs = 0;
+    free_pcb_heap(&arrivals);
 }
 
 /**
@@ -722,12 +2465,61 @@ int get_time_quantum(int num_args, char **argv)
         return 1;
 }
 
+/**
+ * @brief Retrieves the deadlock victim policy from the list of arguments:
+ *        none, held, priority, progress or avoid (or 0 to 4)
+ */
+victim_policy_t get_victim_policy(int num_args, char **argv)
+{
+    char *names[] = {"none", "held", "priority", "progress", "avoid"};
+
+    if (num_args > 5)
+    {
+        for (int i = VICTIM_NONE; i <= VICTIM_AVOID; i++)
+        {
+            if (strcmp(argv[5], names[i]) == 0)
+                return i;
+        }
+        return atoi(argv[5]);
+    }
+    else
+        return VICTIM_FEWEST_HELD;
+}
+
+/**
+ * @brief Retrieves the number of simulated CPUs from the list of arguments
+ */
+int get_num_cpus(int num_args, char **argv)
+{
+    if (num_args > 6)
+        return atoi(argv[6]);
+    else
+        return 1;
+}
+
+/**
+ * @brief Retrieves the number of worker threads from the SCHED_THREADS
+ *        environment variable: a count, or "all" for one per online core.
+ *        0 if it is not set, which keeps the simulated schedulers.
+ */
+int get_num_threads()
+{
+    char *threads = getenv(THREADS_ENV);
+
+    if (threads == NULL)
+        return 0;
+    else if (strcmp(threads, "all") == 0)
+        return (int)sysconf(_SC_NPROCESSORS_ONLN);
+    else
+        return atoi(threads);
+}
+
 /**
  * @brief Print the arguments of the program
  */
 void print_args(char *data1, char *data2, int sched, int tq)
 {
-    printf("Arguments: data1 = %s, data2 = %s, scheduler = %s,  time quantum = %d\n", data1, data2, (sched == 0) ? "priority" : "RR", tq);
+    printf("Arguments: data1 = %s, data2 = %s, scheduler = %s,  time quantum = %d\n", data1, data2, (sched == PRIOR) ? "priority" : (sched == RR) ? "RR" : (sched == CFS) ? "CFS" : "FCFS", tq);
 }
 
 /**
@@ -761,6 +2553,10 @@ void print_alloc_resources(pcb_t *proc)
         for (resource = proc->resources; resource != NULL; resource = resource->next)
         {
             printf(" %s", resource->name);
+            if (resource->instances > 1)
+            {
+                printf("(%d)", resource->instances);
+            }
         }
         printf(" ");
     }
@@ -782,6 +2578,80 @@ void print_queue(pcb_queue_t queue, char *msg)
     printf(" ");
 }
 
+/**
+ * @brief Print <code>msg</code> and the names of the processes in the ready queue of the running scheduler
+ */
+void print_ready_queue(char *msg)
+{
+    char label[64];
+
+    if (cpus != NULL)
+    {
+        for (int c = 0; c < num_cpus; c++)
+        {
+            snprintf(label, sizeof(label), "%s (CPU %d)", msg, c);
+            if (ready_order == READY_HEAP)
+            {
+                print_pcb_heap(&cpus[c].heap, label);
+            }
+            else if (ready_order == READY_TREE)
+            {
+                print_pcb_tree(&cpus[c].tree, label);
+            }
+            else
+            {
+                print_queue(cpus[c].queue, label);
+            }
+        }
+    }
+    else if (ready_order == READY_HEAP)
+    {
+        print_pcb_heap(&readyh, msg);
+    }
+    else if (ready_order == READY_TREE)
+    {
+        print_pcb_tree(&readyt, msg);
+    }
+    else
+    {
+        print_queue(readyq, msg);
+    }
+}
+
+/**
+ * @brief Print <code>msg</code> and the names of the waiting processes, per resource in resource id order,
+ *        then per mailbox in mailbox id order, then those refused an unsafe request
+ */
+void print_waiting_queues(char *msg)
+{
+    pcb_t *proc;
+
+    printf("%s:", msg);
+    for (int i = 0; i < num_waitqs; i++)
+    {
+        for (proc = waitqs[i].first; proc != NULL; proc = proc->next)
+        {
+            printf(" %s", proc->process_in_mem->name);
+        }
+    }
+    for (int i = 0; i < num_mailbox_bufs; i++)
+    {
+        for (proc = mailbox_bufs[i].receivers.first; proc != NULL; proc = proc->next)
+        {
+            printf(" %s", proc->process_in_mem->name);
+        }
+        for (proc = mailbox_bufs[i].senders.first; proc != NULL; proc = proc->next)
+        {
+            printf(" %s", proc->process_in_mem->name);
+        }
+    }
+    for (proc = unsafe_waitq.first; proc != NULL; proc = proc->next)
+    {
+        printf(" %s", proc->process_in_mem->name);
+    }
+    printf(" ");
+}
+
 /**
  * @brief Print <code>msg</code> and the names of the process currently running
  */
@@ -796,28 +2666,26 @@ void print_running(pcb_t *proc, char *msg)
 }
 
 /**
- * @brief Print a linked list of instructions
+ * @brief Print the program of a process
  */
-void print_instructions(instr_t *instr)
+void print_instructions(process_in_mem_t *proc)
 {
-    instr_t *tmp_instr = instr;
-    while (tmp_instr != NULL)
+    for (int i = 0; i < proc->num_instrs; i++)
     {
-        switch (tmp_instr->type)
+        switch (proc->ops[i])
         {
         case REQ_OP:
-            printf("(req %s)\n", tmp_instr->resource_name);
+            printf("(req %s)\n", get_resource_name(proc->ids[i]));
             break;
         case REL_OP:
-            printf("(rel %s)\n", tmp_instr->resource_name);
+            printf("(rel %s)\n", get_resource_name(proc->ids[i]));
             break;
         case SEND_OP:
-            printf("(send %s %s)\n", tmp_instr->resource_name, tmp_instr->msg);
+            printf("(send %s %s)\n", get_mailbox_name(proc->ids[i]), proc->msgs[i]);
             break;
         case RECV_OP:
-            printf("(recv %s %s)\n", tmp_instr->resource_name, tmp_instr->msg);
+            printf("(recv %s %s)\n", get_mailbox_name(proc->ids[i]), proc->msgs[i]);
             break;
         }
-        tmp_instr = tmp_instr->next;
     }
 }
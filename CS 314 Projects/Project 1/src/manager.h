@@ -7,7 +7,19 @@
 #include "proc_structs.h"
 #include "proc_gen.h"
 
-typedef enum {PRIOR = 0, RR, FCFS} schedule_t;
+typedef enum {PRIOR = 0, RR, FCFS, CFS} schedule_t;
+
+/** How the ready queue is ordered: readyq, readyh or readyt of the simulation */
+typedef enum {READY_FIFO = 0, READY_HEAP, READY_TREE} ready_order_t;
+
+/** How resolve_deadlock() chooses the process to roll back */
+typedef enum {
+    VICTIM_NONE = 0,        /* only detect deadlocks */
+    VICTIM_FEWEST_HELD,     /* the process holding the fewest resources */
+    VICTIM_LOWEST_PRIORITY, /* the process with the lowest priority */
+    VICTIM_LEAST_PROGRESS,  /* the process that executed the fewest instructions */
+    VICTIM_AVOID            /* avoid deadlocks with the Banker's algorithm; any found anyway as VICTIM_FEWEST_HELD */
+} victim_policy_t;
 
 typedef struct pcb_queue_t {
     struct pcb_t *first;
@@ -16,8 +28,11 @@ typedef struct pcb_queue_t {
 
 /* --- Function Prototypes -------------------------------------------------- */
 
+/** Sets the manager's defaults in a new simulation, see init_sim(). */
+void init_manager(sim_t *sim);
+
 /** Initializes the manager. */
-void init_queues(pcb_t *procs_loaded);
+void init_queues(sim_t *sim, pcb_t *procs_loaded);
 
 /**
  * Schedules processes.
@@ -25,9 +40,37 @@ void init_queues(pcb_t *procs_loaded);
  * @param[in]  algorithm 
  * @param[in]  time_quantum
  */
-void schedule_processes(schedule_t algorithm, int time_quantum);
+void schedule_processes(sim_t *sim, schedule_t algorithm, int time_quantum);
+
+/** Sets the deadlock victim selection policy, VICTIM_FEWEST_HELD by default */
+void set_victim_policy(sim_t *sim, victim_policy_t policy);
+
+/** Sets the number of simulated CPUs, 1 by default; more than 1 selects SMP mode */
+void set_num_cpus(sim_t *sim, int count);
+
+/** Sets the number of worker threads, 0 by default; more than 0 selects the threaded backend */
+void set_num_threads(sim_t *sim, int count);
+
+/**
+ * Loads the processes: generated if <code>data1</code> is "generate", with
+ * the generator settings <code>data2</code>, else parsed from the process
+ * files <code>data1</code> and <code>data2</code>.
+ *
+ * @return the initial processes, NULL if none could be loaded
+ */
+pcb_t *load_processes(sim_t *sim, char *data1, char *data2);
+
+/**
+ * Runs one simulation of the loaded processes: builds the queues, schedules
+ * them, frees the manager and the loaded processes and reports the phase times.
+ *
+ * @param[in]  procs_loaded the initial processes returned by load_processes()
+ * @param[in]  algorithm
+ * @param[in]  time_quantum
+ */
+void run_processes(sim_t *sim, pcb_t *procs_loaded, schedule_t algorithm, int time_quantum);
 
 /** Frees the manager. */
-void free_manager(void);
+void free_manager(sim_t *sim);
 
 #endif 
@@ -0,0 +1,306 @@
+/**
+ * @file metrics.c
+ *
+ * All times are in ticks of the manager's logical clock. For a terminated
+ * process the turnaround time runs from its arrival to its termination, the
+ * waiting time is the time it spent in the ready queue, and the response
+ * time runs from its arrival to its first dispatch.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "metrics.h"
+#include "sim.h"
+
+#define METRICS_ENV "SCHED_METRICS"
+#define METRICS_CSV_FILENAME "scheduler_metrics.csv"
+#define METRICS_JSON_FILENAME "scheduler_metrics.json"
+#define TIMING_ENV "SCHED_TIMING"
+
+static char *phase_names[NUM_PHASES] = {"parse", "load", "schedule", "teardown"};
+
+/** The distribution of one time over the terminated processes */
+typedef struct time_stats_t {
+    double mean;
+    long p50;
+    long p95;
+    long p99;
+} time_stats_t;
+
+static int cmp_long(const void *a, const void *b)
+{
+    long x = *(const long *)a, y = *(const long *)b;
+    return (x > y) - (x < y);
+}
+
+/** Returns the nearest-rank percentile p of the n sorted times */
+static long percentile(long *sorted, int n, int p)
+{
+    int rank = (int)(((long)p * n + 99) / 100);
+    return sorted[rank > 0 ? rank - 1 : 0];
+}
+
+/** Sorts the n times and summarises them */
+static time_stats_t summarise(long *times, int n)
+{
+    time_stats_t stats = {0.0, 0, 0, 0};
+    double sum = 0.0;
+    int i;
+
+    if (n == 0)
+    {
+        return stats;
+    }
+
+    qsort(times, n, sizeof(long), cmp_long);
+    for (i = 0; i < n; i++)
+    {
+        sum += times[i];
+    }
+    stats.mean = sum / n;
+    stats.p50 = percentile(times, n, 50);
+    stats.p95 = percentile(times, n, 95);
+    stats.p99 = percentile(times, n, 99);
+    return stats;
+}
+
+/** Returns the fraction of the instance-ticks of resource id during which an instance was held */
+static double utilisation(sim_t *sim, run_stats_t *stats, int id)
+{
+    unsigned long capacity = stats->ticks * get_resource(sim, id)->instances;
+
+    return capacity ? (double)stats->busy_ticks[id] / capacity : 0.0;
+}
+
+/** Opens a metrics file for appending, writing the header if it is new */
+static FILE *open_metrics_file(sim_t *sim, char *name, char *header)
+{
+    char *filename = sim_path(sim, name);
+    FILE *fptr = fopen(filename, "a");
+
+    if (fptr == NULL)
+    {
+        fprintf(sim->err, "Error opening %s\n", filename);
+        free(filename);
+        return NULL;
+    }
+    free(filename);
+    fseek(fptr, 0, SEEK_END);
+    if (header != NULL && ftell(fptr) == 0)
+    {
+        fputs(header, fptr);
+    }
+    return fptr;
+}
+
+static void print_text(sim_t *sim, run_stats_t *stats, int completed, double throughput,
+    time_stats_t *turnaround, time_stats_t *wait, time_stats_t *response)
+{
+    int id;
+
+    fprintf(sim->out, "Metrics (%s): %d of %d processes terminated in %lu ticks, throughput %.4f per tick, %lu context switches\n",
+        stats->scheduler, completed, stats->num_procs, stats->ticks, throughput, stats->context_switches);
+    fprintf(sim->out, "  turnaround: mean %.2f p50 %ld p95 %ld p99 %ld\n", turnaround->mean, turnaround->p50, turnaround->p95, turnaround->p99);
+    fprintf(sim->out, "  waiting:    mean %.2f p50 %ld p95 %ld p99 %ld\n", wait->mean, wait->p50, wait->p95, wait->p99);
+    fprintf(sim->out, "  response:   mean %.2f p50 %ld p95 %ld p99 %ld\n", response->mean, response->p50, response->p95, response->p99);
+    fprintf(sim->out, "  utilisation:");
+    for (id = 0; id < stats->num_resources; id++)
+    {
+        if (get_resource(sim, id) != NULL)
+        {
+            fprintf(sim->out, " %s %.1f%%", get_resource_name(sim, id), 100.0 * utilisation(sim, stats, id));
+        }
+    }
+    fprintf(sim->out, "\n");
+}
+
+/** Appends one row; the utilisation of each resource is a name=value list */
+static void write_csv(sim_t *sim, run_stats_t *stats, int completed, double throughput,
+    time_stats_t *turnaround, time_stats_t *wait, time_stats_t *response)
+{
+    FILE *fptr = open_metrics_file(sim, METRICS_CSV_FILENAME,
+        "scheduler,processes,terminated,ticks,throughput,context_switches,"
+        "turnaround_mean,turnaround_p50,turnaround_p95,turnaround_p99,"
+        "wait_mean,wait_p50,wait_p95,wait_p99,"
+        "response_mean,response_p50,response_p95,response_p99,utilisation\n");
+    char *sep = "";
+    int id;
+
+    if (fptr == NULL)
+    {
+        return;
+    }
+
+    fprintf(fptr, "%s,%d,%d,%lu,%.6f,%lu,", stats->scheduler, stats->num_procs, completed,
+        stats->ticks, throughput, stats->context_switches);
+    fprintf(fptr, "%.3f,%ld,%ld,%ld,", turnaround->mean, turnaround->p50, turnaround->p95, turnaround->p99);
+    fprintf(fptr, "%.3f,%ld,%ld,%ld,", wait->mean, wait->p50, wait->p95, wait->p99);
+    fprintf(fptr, "%.3f,%ld,%ld,%ld,\"", response->mean, response->p50, response->p95, response->p99);
+    for (id = 0; id < stats->num_resources; id++)
+    {
+        if (get_resource(sim, id) != NULL)
+        {
+            fprintf(fptr, "%s%s=%.4f", sep, get_resource_name(sim, id), utilisation(sim, stats, id));
+            sep = ";";
+        }
+    }
+    fprintf(fptr, "\"\n");
+    fclose(fptr);
+}
+
+static void write_json_times(FILE *fptr, char *name, time_stats_t *times)
+{
+    fprintf(fptr, "\"%s\":{\"mean\":%.3f,\"p50\":%ld,\"p95\":%ld,\"p99\":%ld},",
+        name, times->mean, times->p50, times->p95, times->p99);
+}
+
+/** Appends one JSON object per line (JSON Lines) */
+static void write_json(sim_t *sim, run_stats_t *stats, int completed, double throughput,
+    time_stats_t *turnaround, time_stats_t *wait, time_stats_t *response)
+{
+    FILE *fptr = open_metrics_file(sim, METRICS_JSON_FILENAME, NULL);
+    char *sep = "";
+    int id;
+
+    if (fptr == NULL)
+    {
+        return;
+    }
+
+    fprintf(fptr, "{\"scheduler\":\"%s\",\"processes\":%d,\"terminated\":%d,\"ticks\":%lu,"
+        "\"throughput\":%.6f,\"context_switches\":%lu,", stats->scheduler, stats->num_procs,
+        completed, stats->ticks, throughput, stats->context_switches);
+    write_json_times(fptr, "turnaround", turnaround);
+    write_json_times(fptr, "wait", wait);
+    write_json_times(fptr, "response", response);
+    fprintf(fptr, "\"utilisation\":{");
+    for (id = 0; id < stats->num_resources; id++)
+    {
+        if (get_resource(sim, id) != NULL)
+        {
+            fprintf(fptr, "%s\"%s\":%.4f", sep, get_resource_name(sim, id), utilisation(sim, stats, id));
+            sep = ",";
+        }
+    }
+    fprintf(fptr, "}}\n");
+    fclose(fptr);
+}
+
+void init_metrics(sim_t *sim)
+{
+    char *format = getenv(METRICS_ENV);
+
+    sim->metrics.format = METRICS_NONE;
+    if (format != NULL && strcmp(format, "text") == 0)
+    {
+        sim->metrics.format = METRICS_TEXT;
+    }
+    else if (format != NULL && strcmp(format, "csv") == 0)
+    {
+        sim->metrics.format = METRICS_CSV;
+    }
+    else if (format != NULL && strcmp(format, "json") == 0)
+    {
+        sim->metrics.format = METRICS_JSON;
+    }
+    else if (format != NULL)
+    {
+        fprintf(sim->err, "%s: unknown format %s\n", METRICS_ENV, format);
+    }
+    sim->metrics.timing = getenv(TIMING_ENV) != NULL;
+    memset(sim->metrics.phase_ms, 0, sizeof(sim->metrics.phase_ms));
+    sim->metrics.cur_phase = -1;
+}
+
+void report_metrics(sim_t *sim, run_stats_t *stats, pcb_t *completed)
+{
+    metrics_format_t format = sim->metrics.format;
+    long *turnaround, *wait, *response;
+    time_stats_t turnaround_stats, wait_stats, response_stats;
+    double throughput;
+    pcb_t *pcb;
+    int n = 0;
+
+    if (format == METRICS_NONE)
+    {
+        return;
+    }
+
+    turnaround = malloc((stats->num_procs + 1) * sizeof(long));
+    wait = malloc((stats->num_procs + 1) * sizeof(long));
+    response = malloc((stats->num_procs + 1) * sizeof(long));
+    for (pcb = completed; pcb != NULL && n < stats->num_procs; pcb = pcb->next, n++)
+    {
+        turnaround[n] = pcb->completion - pcb->arrival;
+        wait[n] = pcb->wait;
+        response[n] = (pcb->first_run != NO_TICK) ? pcb->first_run - pcb->arrival : turnaround[n];
+    }
+    turnaround_stats = summarise(turnaround, n);
+    wait_stats = summarise(wait, n);
+    response_stats = summarise(response, n);
+    throughput = stats->ticks ? (double)n / stats->ticks : 0.0;
+
+    switch (format)
+    {
+    case METRICS_TEXT:
+        print_text(sim, stats, n, throughput, &turnaround_stats, &wait_stats, &response_stats);
+        break;
+    case METRICS_CSV:
+        write_csv(sim, stats, n, throughput, &turnaround_stats, &wait_stats, &response_stats);
+        break;
+    case METRICS_JSON:
+        write_json(sim, stats, n, throughput, &turnaround_stats, &wait_stats, &response_stats);
+        break;
+    default:
+        break;
+    }
+
+    free(turnaround);
+    free(wait);
+    free(response);
+}
+
+double ms_since(struct timespec *start)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) * 1e3 + (now.tv_nsec - start->tv_nsec) / 1e6;
+}
+
+void begin_phase(sim_t *sim, phase_t phase)
+{
+    metrics_t *metrics = &sim->metrics;
+
+    if (metrics->cur_phase >= 0)
+    {
+        metrics->phase_ms[metrics->cur_phase] += ms_since(&metrics->phase_start);
+    }
+    metrics->cur_phase = phase;
+    clock_gettime(CLOCK_MONOTONIC, &metrics->phase_start);
+}
+
+void report_phase_times(sim_t *sim)
+{
+    metrics_t *metrics = &sim->metrics;
+    int i;
+
+    if (metrics->cur_phase >= 0)
+    {
+        metrics->phase_ms[metrics->cur_phase] += ms_since(&metrics->phase_start);
+        metrics->cur_phase = -1;
+    }
+    if (!metrics->timing)
+    {
+        return;
+    }
+
+    fprintf(sim->err, "phase_ms");
+    for (i = 0; i < NUM_PHASES; i++)
+    {
+        fprintf(sim->err, " %s=%.3f", phase_names[i], metrics->phase_ms[i]);
+    }
+    fprintf(sim->err, "\n");
+}
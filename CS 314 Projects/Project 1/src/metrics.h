@@ -0,0 +1,71 @@
+/**
+ * @file metrics.h
+ * @description Timing statistics of a scheduling run: turnaround, waiting
+ *              and response times of the processes, context switches and
+ *              resource utilisation, reported as text, CSV or JSON, and the
+ *              wall-clock time of each phase of the run.
+ */
+#ifndef _METRICS_H
+#define _METRICS_H
+
+#include <time.h>
+
+#include "proc_structs.h"
+
+/** Report formats, see init_metrics() */
+typedef enum {METRICS_NONE = 0, METRICS_TEXT, METRICS_CSV, METRICS_JSON} metrics_format_t;
+
+/** What the manager counted during a run, besides the times kept in each pcb */
+typedef struct run_stats_t {
+    char *scheduler;                /* name of the scheduling algorithm */
+    int num_procs;                  /* processes loaded */
+    unsigned long ticks;            /* logical clock when scheduling ended */
+    unsigned long context_switches; /* dispatches of a process other than the last one run */
+    int num_resources;              /* entries in busy_ticks */
+    unsigned long *busy_ticks;      /* resource id -> instance-ticks the resource was held */
+} run_stats_t;
+
+/** The phases of a run timed by begin_phase() */
+typedef enum {
+    PHASE_PARSE = 0, /* parsing or generating the processes */
+    PHASE_LOAD,      /* building the manager's queues */
+    PHASE_SCHEDULE,  /* scheduling the processes */
+    PHASE_TEARDOWN,  /* freeing the manager and the loaded processes */
+    NUM_PHASES
+} phase_t;
+
+/**
+ * @brief Sets the report format of a new simulation to the one chosen with
+ * the SCHED_METRICS environment variable: "text" prints the report, "csv" and
+ * "json" append one record per run to scheduler_metrics.csv or
+ * scheduler_metrics.json. METRICS_NONE if the variable is not set. Also
+ * resets the phase timer.
+ */
+void init_metrics(sim_t *sim);
+
+/**
+ * @brief Computes the statistics of a run and reports them in the chosen format.
+ *
+ * @param stats The counters kept by the manager.
+ * @param completed The linked list of terminated processes.
+ */
+void report_metrics(sim_t *sim, run_stats_t *stats, pcb_t *completed);
+
+/**
+ * @brief Ends the phase in progress, if any, and starts timing <code>phase</code>
+ * on the monotonic clock.
+ */
+void begin_phase(sim_t *sim, phase_t phase);
+
+/**
+ * @brief Ends the phase in progress and, if the SCHED_TIMING environment
+ * variable is set, prints the time of each phase in milliseconds to the error
+ * stream of the simulation (stderr unless a batch run redirects it):
+ * "phase_ms parse=<ms> load=<ms> schedule=<ms> teardown=<ms>".
+ */
+void report_phase_times(sim_t *sim);
+
+/** @brief Returns the milliseconds elapsed on the monotonic clock since <code>start</code> */
+double ms_since(struct timespec *start);
+
+#endif
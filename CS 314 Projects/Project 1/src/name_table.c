@@ -0,0 +1,93 @@
+/**
+ * @file name_table.c
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include "name_table.h"
+
+#define INIT_SLOTS 64
+
+/* FNV-1a hash of a string */
+static unsigned int hash_name(const char *name) {
+    unsigned int h = 2166136261u;
+    for (; *name; name++)
+        h = (h ^ (unsigned char) *name) * 16777619u;
+    return h;
+}
+
+/* Returns the slot holding name, or the empty slot where it belongs */
+static int find_slot(name_table_t *table, const char *name) {
+    int i = hash_name(name) & (table->num_slots - 1);
+
+    while (table->names[i] && strcmp(table->names[i], name) != 0)
+        i = (i + 1) & (table->num_slots - 1);
+    return i;
+}
+
+/* Doubles the number of slots and rehashes the names */
+static void grow_table(name_table_t *table) {
+    char **old_names = table->names;
+    int *old_ids = table->ids;
+    int old_slots = table->num_slots, i, slot;
+
+    table->num_slots = old_slots ? 2 * old_slots : INIT_SLOTS;
+    table->names = calloc(table->num_slots, sizeof(char *));
+    table->ids = malloc(table->num_slots * sizeof(int));
+    /* the load factor keeps num_names below num_slots / 2 */
+    table->by_id = realloc(table->by_id, table->num_slots / 2 * sizeof(char *));
+
+    for (i = 0; i < old_slots; i++) {
+        if (old_names[i]) {
+            slot = find_slot(table, old_names[i]);
+            table->names[slot] = old_names[i];
+            table->ids[slot] = old_ids[i];
+        }
+    }
+    free(old_names);
+    free(old_ids);
+}
+
+void init_name_table(name_table_t *table) {
+    table->names = NULL;
+    table->ids = NULL;
+    table->by_id = NULL;
+    table->num_names = 0;
+    table->num_slots = 0;
+}
+
+int find_name(name_table_t *table, const char *name) {
+    int slot;
+
+    if (table->num_slots == 0 || name == NULL) return NO_ID;
+    slot = find_slot(table, name);
+    return table->names[slot] ? table->ids[slot] : NO_ID;
+}
+
+int intern_name(name_table_t *table, char *name) {
+    int slot;
+
+    if (name == NULL) return NO_ID;
+    /* keep the load factor at or below one half */
+    if (2 * (table->num_names + 1) > table->num_slots) grow_table(table);
+
+    slot = find_slot(table, name);
+    if (!table->names[slot]) {
+        table->names[slot] = name;
+        table->ids[slot] = table->num_names;
+        table->by_id[table->num_names++] = table->names[slot];
+    }
+    return table->ids[slot];
+}
+
+char *get_name(name_table_t *table, int id) {
+    if (id < 0 || id >= table->num_names) return NULL;
+    return table->by_id[id];
+}
+
+void free_name_table(name_table_t *table) {
+    free(table->names);
+    free(table->ids);
+    free(table->by_id);
+    init_name_table(table);
+}
@@ -0,0 +1,41 @@
+/**
+ * @file name_table.h
+ * @description A hash table that interns names (of resources, processes,
+ *              mailboxes) into dense integer ids 0, 1, 2, ...
+ *              The table does not copy the names: it keeps the caller's
+ *              pointers, which point into the parsed process files or the
+ *              loader's arena and outlive the table.
+ */
+#ifndef _NAME_TABLE_H
+#define _NAME_TABLE_H
+
+#define NO_ID -1
+
+/** An open-addressing table from name to id */
+typedef struct name_table_t {
+  char **names;  /* slot -> the name, NULL if the slot is empty */
+  int *ids;      /* slot -> id of the name */
+  char **by_id;  /* id -> the name held in names */
+  int num_names; /* the next id to hand out */
+  int num_slots; /* always a power of two */
+} name_table_t;
+
+/** Initialises an empty table */
+void init_name_table(name_table_t *table);
+
+/** Returns the id of <code>name</code>, or NO_ID if it was never interned */
+int find_name(name_table_t *table, const char *name);
+
+/**
+ * Returns the id of <code>name</code>, giving it the next free id if it is
+ * new. A new name is not copied, so it must stay valid until the table is freed.
+ */
+int intern_name(name_table_t *table, char *name);
+
+/** Returns the name with id <code>id</code>, or NULL if no name has that id */
+char *get_name(name_table_t *table, int id);
+
+/** Frees the table, but not the names */
+void free_name_table(name_table_t *table);
+
+#endif
@@ -0,0 +1,139 @@
+/**
+ * @file pcb_heap.c
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pcb_heap.h"
+
+#define INIT_HEAP_SZ 64
+
+/** Returns TRUE if entry a must be popped before entry b */
+static bool_t before(pcb_heap_entry_t *a, pcb_heap_entry_t *b)
+{
+    if (a->key != b->key)
+    {
+        return a->key > b->key;
+    }
+    return a->seq < b->seq;
+}
+
+static void swap(pcb_heap_entry_t *a, pcb_heap_entry_t *b)
+{
+    pcb_heap_entry_t tmp = *a;
+    *a = *b;
+    *b = tmp;
+}
+
+void init_pcb_heap(pcb_heap_t *heap)
+{
+    heap->entries = NULL;
+    heap->size = 0;
+    heap->capacity = 0;
+    heap->next_seq = 0;
+}
+
+void push_pcb(pcb_heap_t *heap, pcb_t *pcb)
+{
+    push_pcb_keyed(heap, pcb, pcb->priority);
+}
+
+void push_pcb_keyed(pcb_heap_t *heap, pcb_t *pcb, long key)
+{
+    int i, parent;
+
+    if (heap->size == heap->capacity)
+    {
+        heap->capacity = heap->capacity ? 2 * heap->capacity : INIT_HEAP_SZ;
+        heap->entries = realloc(heap->entries, heap->capacity * sizeof(pcb_heap_entry_t));
+    }
+
+    i = heap->size++;
+    heap->entries[i].pcb = pcb;
+    heap->entries[i].key = key;
+    heap->entries[i].seq = heap->next_seq++;
+    pcb->next = NULL;
+
+    /* sift up */
+    while (i > 0)
+    {
+        parent = (i - 1) / 2;
+        if (!before(&heap->entries[i], &heap->entries[parent]))
+        {
+            break;
+        }
+        swap(&heap->entries[i], &heap->entries[parent]);
+        i = parent;
+    }
+}
+
+pcb_t *pop_pcb(pcb_heap_t *heap)
+{
+    pcb_t *top;
+    int i = 0, child;
+
+    if (heap->size == 0)
+    {
+        return NULL;
+    }
+
+    top = heap->entries[0].pcb;
+    heap->entries[0] = heap->entries[--heap->size];
+
+    /* sift down */
+    while ((child = 2 * i + 1) < heap->size)
+    {
+        if (child + 1 < heap->size && before(&heap->entries[child + 1], &heap->entries[child]))
+        {
+            child++;
+        }
+        if (!before(&heap->entries[child], &heap->entries[i]))
+        {
+            break;
+        }
+        swap(&heap->entries[i], &heap->entries[child]);
+        i = child;
+    }
+
+    return top;
+}
+
+pcb_t *peek_pcb(pcb_heap_t *heap)
+{
+    return heap->size ? heap->entries[0].pcb : NULL;
+}
+
+void free_pcb_heap(pcb_heap_t *heap)
+{
+    free(heap->entries);
+    init_pcb_heap(heap);
+}
+
+/** Orders heap entries by push order */
+static int cmp_seq(const void *a, const void *b)
+{
+    unsigned long sa = ((const pcb_heap_entry_t *)a)->seq;
+    unsigned long sb = ((const pcb_heap_entry_t *)b)->seq;
+    return (sa > sb) - (sa < sb);
+}
+
+void print_pcb_heap(pcb_heap_t *heap, char *msg, FILE *out)
+{
+    pcb_heap_entry_t *sorted = malloc((heap->size ? heap->size : 1) * sizeof(pcb_heap_entry_t));
+    int i;
+
+    if (heap->size > 0)
+    {
+        memcpy(sorted, heap->entries, heap->size * sizeof(pcb_heap_entry_t));
+    }
+    qsort(sorted, heap->size, sizeof(pcb_heap_entry_t), cmp_seq);
+
+    fprintf(out, "%s:", msg);
+    for (i = 0; i < heap->size; i++)
+    {
+        fprintf(out, " %s", sorted[i].pcb->process_in_mem->name);
+    }
+    fprintf(out, " ");
+    free(sorted);
+}
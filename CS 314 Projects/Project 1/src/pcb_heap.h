@@ -0,0 +1,53 @@
+/**
+ * @file pcb_heap.h
+ * @description A binary max-heap of PCBs ordered by priority, used as the
+ *              ready queue of the priority scheduler. PCBs may also be pushed
+ *              with an explicit key, e.g. to order them by arrival time.
+ */
+#ifndef _PCB_HEAP_H
+#define _PCB_HEAP_H
+
+#include <stdio.h>
+
+#include "proc_structs.h"
+
+/** A heap entry: the pcb, its key and the order in which it was pushed */
+typedef struct pcb_heap_entry_t {
+    struct pcb_t *pcb;
+    long key;
+    unsigned long seq;
+} pcb_heap_entry_t;
+
+/**
+ * Higher keys (by default, priorities) are popped first. PCBs with equal
+ * keys are popped in the order in which they were pushed (FIFO).
+ */
+typedef struct pcb_heap_t {
+    pcb_heap_entry_t *entries;
+    int size;
+    int capacity;
+    unsigned long next_seq;
+} pcb_heap_t;
+
+/** Initialises an empty heap */
+void init_pcb_heap(pcb_heap_t *heap);
+
+/** Pushes <code>pcb</code> onto the heap in O(log n), keyed by its priority */
+void push_pcb(pcb_heap_t *heap, pcb_t *pcb);
+
+/** Pushes <code>pcb</code> onto the heap in O(log n) with key <code>key</code> */
+void push_pcb_keyed(pcb_heap_t *heap, pcb_t *pcb, long key);
+
+/** Removes and returns the highest priority pcb in O(log n), NULL if empty */
+pcb_t *pop_pcb(pcb_heap_t *heap);
+
+/** Returns the highest priority pcb without removing it, NULL if empty */
+pcb_t *peek_pcb(pcb_heap_t *heap);
+
+/** Frees the entries of the heap (not the PCBs) */
+void free_pcb_heap(pcb_heap_t *heap);
+
+/** Prints <code>msg</code> and the names of the PCBs in the order they were pushed to <code>out</code> */
+void print_pcb_heap(pcb_heap_t *heap, char *msg, FILE *out);
+
+#endif
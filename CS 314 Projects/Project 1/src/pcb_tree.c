@@ -0,0 +1,312 @@
+/**
+ * @file pcb_tree.c
+ *
+ * A red-black tree as in Cormen et al., with NULL leaves: the parent of a
+ * NULL child is tracked explicitly while rebalancing after a removal.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "pcb_tree.h"
+
+/** Returns TRUE if pcb a comes before pcb b */
+static bool_t before(pcb_t *a, pcb_t *b)
+{
+    if (a->vruntime != b->vruntime)
+    {
+        return a->vruntime < b->vruntime;
+    }
+    return a->tree_seq < b->tree_seq;
+}
+
+static bool_t is_red(pcb_t *pcb)
+{
+    return pcb != NULL && pcb->tree_red;
+}
+
+/** Replaces <code>old</code> by <code>pcb</code> as a child of the parent of <code>old</code> */
+static void replace_child(pcb_tree_t *tree, pcb_t *old, pcb_t *pcb)
+{
+    pcb_t *parent = old->tree_parent;
+
+    if (parent == NULL)
+    {
+        tree->root = pcb;
+    }
+    else if (old == parent->tree_left)
+    {
+        parent->tree_left = pcb;
+    }
+    else
+    {
+        parent->tree_right = pcb;
+    }
+    if (pcb != NULL)
+    {
+        pcb->tree_parent = parent;
+    }
+}
+
+static void rotate_left(pcb_tree_t *tree, pcb_t *x)
+{
+    pcb_t *y = x->tree_right;
+
+    x->tree_right = y->tree_left;
+    if (y->tree_left != NULL)
+    {
+        y->tree_left->tree_parent = x;
+    }
+    replace_child(tree, x, y);
+    y->tree_left = x;
+    x->tree_parent = y;
+}
+
+static void rotate_right(pcb_tree_t *tree, pcb_t *x)
+{
+    pcb_t *y = x->tree_left;
+
+    x->tree_left = y->tree_right;
+    if (y->tree_right != NULL)
+    {
+        y->tree_right->tree_parent = x;
+    }
+    replace_child(tree, x, y);
+    y->tree_right = x;
+    x->tree_parent = y;
+}
+
+/** Restores the red-black properties after inserting the red pcb <code>pcb</code> */
+static void fix_insert(pcb_tree_t *tree, pcb_t *pcb)
+{
+    pcb_t *parent, *grandparent, *uncle;
+
+    while (is_red(parent = pcb->tree_parent))
+    {
+        /* a red parent is not the root, so the grandparent exists */
+        grandparent = parent->tree_parent;
+        if (parent == grandparent->tree_left)
+        {
+            uncle = grandparent->tree_right;
+            if (is_red(uncle))
+            {
+                parent->tree_red = uncle->tree_red = FALSE;
+                grandparent->tree_red = TRUE;
+                pcb = grandparent;
+                continue;
+            }
+            if (pcb == parent->tree_right)
+            {
+                rotate_left(tree, parent);
+                pcb = parent;
+                parent = pcb->tree_parent;
+            }
+            parent->tree_red = FALSE;
+            grandparent->tree_red = TRUE;
+            rotate_right(tree, grandparent);
+        }
+        else
+        {
+            uncle = grandparent->tree_left;
+            if (is_red(uncle))
+            {
+                parent->tree_red = uncle->tree_red = FALSE;
+                grandparent->tree_red = TRUE;
+                pcb = grandparent;
+                continue;
+            }
+            if (pcb == parent->tree_left)
+            {
+                rotate_right(tree, parent);
+                pcb = parent;
+                parent = pcb->tree_parent;
+            }
+            parent->tree_red = FALSE;
+            grandparent->tree_red = TRUE;
+            rotate_left(tree, grandparent);
+        }
+    }
+    tree->root->tree_red = FALSE;
+}
+
+/**
+ * Restores the red-black properties after a black pcb was removed from
+ * above <code>pcb</code> (possibly NULL), a child of <code>parent</code>.
+ */
+static void fix_remove(pcb_tree_t *tree, pcb_t *pcb, pcb_t *parent)
+{
+    pcb_t *sibling;
+
+    while (pcb != tree->root && !is_red(pcb))
+    {
+        /* the side that lost a black pcb has a sibling with a black height of at least 1 */
+        if (pcb == parent->tree_left)
+        {
+            sibling = parent->tree_right;
+            if (is_red(sibling))
+            {
+                sibling->tree_red = FALSE;
+                parent->tree_red = TRUE;
+                rotate_left(tree, parent);
+                sibling = parent->tree_right;
+            }
+            if (!is_red(sibling->tree_left) && !is_red(sibling->tree_right))
+            {
+                sibling->tree_red = TRUE;
+                pcb = parent;
+                parent = pcb->tree_parent;
+                continue;
+            }
+            if (!is_red(sibling->tree_right))
+            {
+                sibling->tree_left->tree_red = FALSE;
+                sibling->tree_red = TRUE;
+                rotate_right(tree, sibling);
+                sibling = parent->tree_right;
+            }
+            sibling->tree_red = parent->tree_red;
+            parent->tree_red = FALSE;
+            sibling->tree_right->tree_red = FALSE;
+            rotate_left(tree, parent);
+        }
+        else
+        {
+            sibling = parent->tree_left;
+            if (is_red(sibling))
+            {
+                sibling->tree_red = FALSE;
+                parent->tree_red = TRUE;
+                rotate_right(tree, parent);
+                sibling = parent->tree_left;
+            }
+            if (!is_red(sibling->tree_left) && !is_red(sibling->tree_right))
+            {
+                sibling->tree_red = TRUE;
+                pcb = parent;
+                parent = pcb->tree_parent;
+                continue;
+            }
+            if (!is_red(sibling->tree_left))
+            {
+                sibling->tree_right->tree_red = FALSE;
+                sibling->tree_red = TRUE;
+                rotate_left(tree, sibling);
+                sibling = parent->tree_left;
+            }
+            sibling->tree_red = parent->tree_red;
+            parent->tree_red = FALSE;
+            sibling->tree_left->tree_red = FALSE;
+            rotate_right(tree, parent);
+        }
+        pcb = tree->root;
+    }
+    if (pcb != NULL)
+    {
+        pcb->tree_red = FALSE;
+    }
+}
+
+void init_pcb_tree(pcb_tree_t *tree)
+{
+    tree->root = NULL;
+    tree->leftmost = NULL;
+    tree->size = 0;
+    tree->next_seq = 0;
+}
+
+void insert_pcb_tree(pcb_tree_t *tree, pcb_t *pcb)
+{
+    pcb_t *parent = NULL, *cur = tree->root;
+    bool_t leftmost = TRUE;
+
+    pcb->tree_seq = tree->next_seq++;
+    while (cur != NULL)
+    {
+        parent = cur;
+        if (before(pcb, cur))
+        {
+            cur = cur->tree_left;
+        }
+        else
+        {
+            cur = cur->tree_right;
+            leftmost = FALSE;
+        }
+    }
+
+    pcb->tree_parent = parent;
+    pcb->tree_left = pcb->tree_right = NULL;
+    pcb->tree_red = TRUE;
+    pcb->next = NULL;
+    if (parent == NULL)
+    {
+        tree->root = pcb;
+    }
+    else if (before(pcb, parent))
+    {
+        parent->tree_left = pcb;
+    }
+    else
+    {
+        parent->tree_right = pcb;
+    }
+    if (leftmost)
+    {
+        tree->leftmost = pcb;
+    }
+    tree->size++;
+    fix_insert(tree, pcb);
+}
+
+pcb_t *pop_leftmost_pcb(pcb_tree_t *tree)
+{
+    pcb_t *first = tree->leftmost, *child, *parent;
+
+    if (first == NULL)
+    {
+        return NULL;
+    }
+
+    /* the leftmost pcb has no left child; its successor is its right child or else its parent */
+    child = first->tree_right;
+    parent = first->tree_parent;
+    tree->leftmost = (child != NULL) ? child : parent;
+    replace_child(tree, first, child);
+    if (!first->tree_red)
+    {
+        fix_remove(tree, child, parent);
+    }
+    tree->size--;
+    first->tree_parent = first->tree_left = first->tree_right = NULL;
+    return first;
+}
+
+pcb_t *peek_leftmost_pcb(pcb_tree_t *tree)
+{
+    return tree->leftmost;
+}
+
+void print_pcb_tree(pcb_tree_t *tree, char *msg, FILE *out)
+{
+    pcb_t *pcb = tree->leftmost;
+
+    fprintf(out, "%s:", msg);
+    while (pcb != NULL)
+    {
+        fprintf(out, " %s", pcb->process_in_mem->name);
+
+        /* in-order successor */
+        if (pcb->tree_right != NULL)
+        {
+            for (pcb = pcb->tree_right; pcb->tree_left != NULL; pcb = pcb->tree_left);
+        }
+        else
+        {
+            while (pcb->tree_parent != NULL && pcb == pcb->tree_parent->tree_right)
+            {
+                pcb = pcb->tree_parent;
+            }
+            pcb = pcb->tree_parent;
+        }
+    }
+    fprintf(out, " ");
+}
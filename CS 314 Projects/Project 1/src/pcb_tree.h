@@ -0,0 +1,42 @@
+/**
+ * @file pcb_tree.h
+ * @description A red-black tree of PCBs ordered by virtual runtime, used as
+ *              the ready queue of the completely fair scheduler. The tree
+ *              links live in the PCBs themselves, so inserting allocates
+ *              nothing, and the leftmost PCB is cached.
+ */
+#ifndef _PCB_TREE_H
+#define _PCB_TREE_H
+
+#include <stdio.h>
+
+#include "proc_structs.h"
+
+/**
+ * Lower virtual runtimes come first. PCBs with equal virtual runtimes come
+ * in the order in which they were inserted (FIFO). A PCB is in at most one
+ * tree at a time.
+ */
+typedef struct pcb_tree_t {
+    struct pcb_t *root;
+    struct pcb_t *leftmost; /* the PCB with the lowest virtual runtime */
+    int size;
+    unsigned long next_seq;
+} pcb_tree_t;
+
+/** Initialises an empty tree */
+void init_pcb_tree(pcb_tree_t *tree);
+
+/** Inserts <code>pcb</code> in O(log n), keyed by its virtual runtime, which must not change while it is in the tree */
+void insert_pcb_tree(pcb_tree_t *tree, pcb_t *pcb);
+
+/** Removes and returns the pcb with the lowest virtual runtime in O(log n), NULL if empty */
+pcb_t *pop_leftmost_pcb(pcb_tree_t *tree);
+
+/** Returns the pcb with the lowest virtual runtime in O(1) without removing it, NULL if empty */
+pcb_t *peek_leftmost_pcb(pcb_tree_t *tree);
+
+/** Prints <code>msg</code> and the names of the PCBs from the lowest virtual runtime up to <code>out</code> */
+void print_pcb_tree(pcb_tree_t *tree, char *msg, FILE *out);
+
+#endif
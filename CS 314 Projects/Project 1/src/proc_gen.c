@@ -1,202 +1,453 @@
 /**
  * @file proc_gen.c
+ *
+ * Generates workloads of any size from a gen_config_t. All random numbers
+ * come from a private xorshift64* generator, so a given seed and
+ * configuration produce the same workload on every platform.
  */
-#include <stdio.h> 
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
 #include <limits.h>
+#include <stdint.h>
 #include <time.h>
+#include <math.h>
 
 #include "proc_structs.h"
+#include "proc_gen.h"
+#include "logger.h"
 
-#define READING 0
-#define END_OF_FILE 2
-#define RELEASE 1
+#define CONFIG_SEPARATORS " \t\r\n,"
 
 const int MAX_NAME_SZ = 32;
 const int MAX_MSG_SZ = 32;
-const int MAX_PROCS = 5;
-const int MAX_NEW_PROCS = 5;
-const int MAX_RESOURCES = 5;
-const int MAX_MAILBOXES = -1;
-const int SUPPORTED_INSTR = 2;
-const int MAX_INSTRS_PER_PROC = 100;
-
-int num_resources = 5;
-int num_mailboxes = 2;
-int num_instructions = 4;
-bool_t srand_called = FALSE;
 
-bool_t gen_init_proc_list(bool_t priority_sched);
-bool_t gen_new_proc_list(bool_t priority_sched);
+static gen_config_t config;
+static uint64_t rand_state;
+static char **resource_names = NULL; /* generated names, shared by all instructions */
+static char **mailbox_names = NULL;
+static char **mailbox_msgs = NULL;
+static long arrival_tick = 0;  /* arrival time of the current burst */
+static int burst_left = 0;     /* processes still to arrive at arrival_tick */
+static int *held = NULL;       /* resources held by the process being generated, ascending unless deadlocks */
+static bool_t *is_held = NULL; /* resource -> TRUE if in held */
+static int num_held = 0;
 
+void init_gen_config(gen_config_t *cfg);
+bool_t read_gen_settings(char *settings, char *origin);
+bool_t gen_proc_list(int num_processes, bool_t arriving);
+long gen_arrival();
 void gen_instrs(char *process_name);
-int gen_prio(int *pr_alloc, int nth);
+int gen_instr_type();
+int gen_request();
+int gen_release();
+int gen_range(int lo, int hi);
 char *gen_name(char type, int id);
 char *gen_msg(char *msg);
 
 /**
- * @brief Generates a random number of processes and loads them into the data structures using the loader 
+ * @brief Sets the generator's configuration to the defaults: 4 initial and
+ *        4 arriving processes with 4 instructions each, 5 resources, no
+ *        mailboxes, all priorities 0, one arrival per tick, requests in
+ *        resource order, seeded from the clock.
  */
-bool_t generate_init_procs() {
-    bool_t success = FALSE;
-    srand(time(0));
-    srand_called = TRUE;
-    init_loader();
-    success = gen_init_proc_list(FALSE);
+void init_gen_config(gen_config_t *cfg) {
+    cfg->seed = 0;
+    cfg->init_procs = 4;
+    cfg->new_procs = 4;
+    cfg->resources = 5;
+    cfg->instances = 1;
+    cfg->mailboxes = 0;
+    cfg->min_instrs = 4;
+    cfg->max_instrs = 4;
+    cfg->max_priority = 0;
+    cfg->arrival_gap = 1;
+    cfg->burst = 1;
+    cfg->poisson = 0;
+    cfg->deadlocks = 0;
+    cfg->export_prefix = NULL;
+}
+
+/**
+ * @brief Configures the workload to generate.
+ *
+ * <code>spec</code> is either a list of <code>key=value</code> settings
+ * separated by commas or whitespace, e.g. "seed=42,procs=1000000", or the
+ * name of a file holding such settings, in which '#' starts a comment. The
+ * keys are seed, procs (initial processes), new_procs (arriving processes),
+ * resources, instances (the most instances of a resource), mailboxes, instrs
+ * (sets min_instrs and max_instrs), min_instrs, max_instrs, max_priority,
+ * arrival_gap, burst, poisson, deadlocks and export.
+ *
+ * The arriving processes arrive in bursts of 1 .. burst processes,
+ * arrival_gap ticks apart; with poisson=1 the gaps are drawn from an
+ * exponential distribution with mean arrival_gap. With deadlocks=1 the
+ * resources are requested in random rather than ascending order, so that
+ * processes can deadlock. The setting export=<prefix> also writes the
+ * generated processes to the process files <prefix>1.list (the initial
+ * processes, resources and mailboxes) and <prefix>2.list (the arriving
+ * processes), which can be parsed to replay the workload.
+ *
+ * Settings that are not given keep their defaults; "generate", "generator"
+ * or NULL selects the defaults.
+ *
+ * @return FALSE if the settings could not be read or are invalid
+ */
+bool_t configure_generator(char *spec) {
+    FILE *fptr;
+    char *settings, *comment;
+    long len;
+    bool_t success;
 
+    init_gen_config(&config);
+    if (spec == NULL || strcmp(spec, "generate") == 0 || strcmp(spec, "generator") == 0) {
+        return TRUE;
+    }
+
+    if (strchr(spec, '=') != NULL) {
+        settings = strdup(spec);
+        success = read_gen_settings(settings, "generator settings");
+        free(settings);
+        return success;
+    }
+
+    fptr = fopen(spec, "r");
+    if (fptr == NULL) {
+        fprintf(stderr, "Error opening generator configuration %s\n", spec);
+        return FALSE;
+    }
+    fseek(fptr, 0, SEEK_END);
+    len = ftell(fptr);
+    rewind(fptr);
+    settings = malloc(len + 1);
+    len = fread(settings, 1, len, fptr);
+    settings[len] = '\0';
+    fclose(fptr);
+
+    /* blank out comments */
+    for (comment = strchr(settings, '#'); comment != NULL; comment = strchr(comment, '#')) {
+        while (*comment != '\0' && *comment != '\n') *comment++ = ' ';
+    }
+    success = read_gen_settings(settings, spec);
+    free(settings);
     return success;
 }
 
 /**
- * @brief Generates a random number of processes and loads them into a linked list of pcbs 
- *        must be called after generate_init_procs(); 
+ * @brief Returns the configuration of the workload being generated.
  */
-bool_t generate_new_procs() {
-    return gen_new_proc_list(FALSE);
+gen_config_t *get_gen_config() {
+    return &config;
 }
 
 /**
- * @brief generates a list of processes and loads it with functions provided in loader.h
+ * @brief Reads <code>key=value</code> settings into the configuration.
  *
+ * @param settings The settings; tokenised in place.
+ * @param origin Where the settings came from, for error messages.
  */
-bool_t gen_init_proc_list(bool_t priority_sched) {
-    char* name;
-    int i, proc_priority = 0;
-    int* priorities_allocated = NULL;
-    bool_t success = FALSE;
+bool_t read_gen_settings(char *settings, char *origin) {
+    struct { char *key; int *value; } keys[] = {
+        {"procs", &config.init_procs}, {"new_procs", &config.new_procs},
+        {"resources", &config.resources}, {"instances", &config.instances},
+        {"mailboxes", &config.mailboxes},
+        {"min_instrs", &config.min_instrs}, {"max_instrs", &config.max_instrs},
+        {"max_priority", &config.max_priority}, {"arrival_gap", &config.arrival_gap},
+        {"burst", &config.burst}, {"poisson", &config.poisson},
+        {"deadlocks", &config.deadlocks}
+    };
+    int num_keys = sizeof(keys) / sizeof(keys[0]);
+    char *setting, *value, *end;
+    unsigned long number;
+    int i;
 
-    /* Generate and load a list of processes */
-    int num_processes = rand() % MAX_PROCS; 
-    if (num_processes < 1) num_processes = 1; 
-    for(i = 0; i < num_processes; i++) {
-        name = gen_name('P', get_num_procs()+1);
-        if (priority_sched) proc_priority = gen_prio(priorities_allocated, i);
-        success = load_process(name, proc_priority);
-        gen_instrs(name);
+    for (setting = strtok(settings, CONFIG_SEPARATORS); setting != NULL;
+            setting = strtok(NULL, CONFIG_SEPARATORS)) {
+        value = strchr(setting, '=');
+        if (value == NULL) {
+            fprintf(stderr, "%s: expected key=value, found %s\n", origin, setting);
+            return FALSE;
+        }
+        *value++ = '\0';
+
+        if (strcmp(setting, "export") == 0) {
+            config.export_prefix = loader_strdup(value);
+            continue;
+        }
+
+        number = strtoul(value, &end, 10);
+        if (!isdigit((unsigned char) *value) || *end != '\0' || (strcmp(setting, "seed") != 0 && number > INT_MAX)) {
+            fprintf(stderr, "%s: invalid value %s for %s\n", origin, value, setting);
+            return FALSE;
+        }
+
+        if (strcmp(setting, "seed") == 0) {
+            config.seed = number;
+        } else if (strcmp(setting, "instrs") == 0) {
+            config.min_instrs = config.max_instrs = number;
+        } else {
+            for (i = 0; i < num_keys && strcmp(setting, keys[i].key) != 0; i++);
+            if (i == num_keys) {
+                fprintf(stderr, "%s: unknown setting %s\n", origin, setting);
+                return FALSE;
+            }
+            *keys[i].value = number;
+        }
     }
 
-    /* Generate and load a list of resources */
-    num_resources = MAX_RESOURCES;
-    if (num_resources < 1) num_resources = 1; 
-    for(i = 0; i < num_resources; i++) {
-        int duplicate = rand() % 2;
-        if (duplicate) name = gen_name('R', i);
-        else name = gen_name('R', i + 1);
-        success = load_resource(name);
+    if (config.burst < 1) {
+        fprintf(stderr, "%s: burst must be at least 1\n", origin);
+        return FALSE;
     }
+    if (config.min_instrs > config.max_instrs) {
+        fprintf(stderr, "%s: min_instrs is greater than max_instrs\n", origin);
+        return FALSE;
+    }
+    return TRUE;
+}
 
-    /* Generate and load a list of mailboxes */
-    if (MAX_MAILBOXES != -1) {
-        num_mailboxes = rand() % MAX_MAILBOXES;
-        if (num_mailboxes < 1) num_mailboxes = 1; 
-        for(i = 0; i < num_mailboxes; i++) {
-            name = gen_name('m', i);
-            success = load_mailbox(name);
-        }
+/**
+ * @brief Generates the processes that are ready when scheduling starts, and the
+ *        resources and mailboxes, and loads them into the data structures using the loader
+ */
+bool_t generate_init_procs() {
+    bool_t success = TRUE;
+    uint64_t z;
+    int i;
+
+    if (config.seed == 0) config.seed = (unsigned long) time(0);
+    printf("Generator seed: %lu\n", config.seed);
+
+    /* splitmix64 scrambles the seed into a non-zero xorshift state */
+    z = (uint64_t) config.seed + 0x9E3779B97F4A7C15ull;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    rand_state = (z ^ (z >> 31)) | 1;
+
+    init_loader();
+    arrival_tick = 0;
+    burst_left = 0;
+
+    /* Generate the names of the resources and mailboxes once */
+    resource_names = loader_alloc((config.resources + 1) * sizeof(char *));
+    for (i = 0; i < config.resources; i++) {
+        resource_names[i] = gen_name('R', i);
+    }
+    held = loader_alloc((config.resources + 1) * sizeof(int));
+    is_held = loader_alloc((config.resources + 1) * sizeof(bool_t));
+    memset(is_held, 0, (config.resources + 1) * sizeof(bool_t));
+    mailbox_names = loader_alloc((config.mailboxes + 1) * sizeof(char *));
+    mailbox_msgs = loader_alloc((config.mailboxes + 1) * sizeof(char *));
+    for (i = 0; i < config.mailboxes; i++) {
+        mailbox_names[i] = gen_name('m', i);
+        mailbox_msgs[i] = gen_msg(mailbox_names[i]);
     }
 
+    /* Load the list of resources and mailboxes first, so that their ids
+     * follow their declaration order as they do for a parsed process file */
+    for (i = 0; i < config.resources; i++) {
+        success = load_resource(resource_names[i], (config.instances > 1) ? gen_range(1, config.instances) : 1) && success;
+    }
+    for (i = 0; i < config.mailboxes; i++) {
+        success = load_mailbox(mailbox_names[i]) && success;
+    }
+
+    success = gen_proc_list(config.init_procs, FALSE) && success;
+
 #   ifdef DEBUG_LOADER
-    printf("Generated: %d processes, %d resources, %d mailboxes\n", num_processes, num_resources, num_mailboxes);
+    if (get_verbosity() >= VERBOSE_DEBUG) {
+        printf("Generated: %d processes, %d resources, %d mailboxes\n", config.init_procs, config.resources, config.mailboxes);
+    }
 #   endif
     return success;
 }
 
 /**
- * Generate a list of processes to arrive in the ready queue during scheduling
+ * @brief Generates the processes to arrive in the ready queue during scheduling
+ *        and loads them into a linked list of pcbs; must be called after generate_init_procs();
+ */
+bool_t generate_new_procs() {
+    return gen_proc_list(config.new_procs, TRUE);
+}
+
+/**
+ * @brief generates a list of processes and loads it with functions provided in loader.h
  *
+ * @param num_processes The number of processes to generate
+ * @param arriving TRUE if the processes arrive during scheduling and need
+ *     arrival times, FALSE if they are ready when scheduling starts
  */
-bool_t gen_new_proc_list(bool_t priority_sched) {
+bool_t gen_proc_list(int num_processes, bool_t arriving) {
     char* name;
-    int i, proc_priority = 0;
-    int* priorities_allocated = NULL;
-    bool_t success = FALSE;
+    int i, priority;
+    bool_t success = TRUE;
 
-    /* Generate and load a list of processes */
-    int num_processes = rand() % MAX_NEW_PROCS; 
-    if (num_processes < 1) num_processes = 1; 
     for(i = 0; i < num_processes; i++) {
         name = gen_name('P', get_num_procs()+1);
-        if (priority_sched) proc_priority = gen_prio(priorities_allocated, i);
-        success = load_process(name, proc_priority);
+        priority = gen_range(0, config.max_priority);
+        success = load_process(name, priority, arriving ? gen_arrival() : NO_ARRIVAL) && success;
         gen_instrs(name);
     }
-    
     return success;
 }
 
 /**
- * @brief Reads the defined instruction for a process and loads it.
+ * @brief Returns the arrival time of the next arriving process.
  *
- * Reads the list of instructions for each process and loads it in the
- * appropriate datastructure using the functions defined in loader.h
+ * Starts a new burst of 1 .. burst processes, arrival_gap ticks (or an
+ * exponentially distributed number of ticks with that mean) after the
+ * previous one, once the current burst is complete.
+ */
+long gen_arrival() {
+    double u;
+
+    if (burst_left == 0) {
+        burst_left = gen_range(1, config.burst);
+        if (config.poisson) {
+            /* u in (0, 1] so that log(u) is finite */
+            u = (gen_range(0, INT_MAX - 1) + 1.0) / INT_MAX;
+            arrival_tick += (long) floor(-log(u) * config.arrival_gap + 0.5);
+        } else {
+            arrival_tick += config.arrival_gap;
+        }
+    }
+    burst_left--;
+    return arrival_tick;
+}
+
+/**
+ * @brief Generates the instructions of a process and loads them.
  *
- * @param process_id 
+ * Loads the instructions of the process in the appropriate datastructure
+ * using the functions defined in loader.h. The program is well-formed: a
+ * process holds at most one instance of a resource, releases only what it
+ * holds and releases everything it holds before it ends. It requests the
+ * resources in ascending order, so no set of processes can wait for each
+ * other in a cycle, unless the deadlocks setting asks for random order.
  *
+ * @param process_name The process whose instructions to generate
  */
 void gen_instrs(char *process_name) {
-    char *name;
+    int i, num_instrs = gen_range(config.min_instrs, config.max_instrs);
+    int mailbox, instruction, left;
+    bool_t can_request;
+
+    if (config.resources == 0 && config.mailboxes == 0) num_instrs = 0;
+
+    for (i = 0; i < num_instrs; i++) {
+        left = num_instrs - i;
+        /* a request needs room for its release and those of what is held */
+        can_request = left >= num_held + 2 && num_held < config.resources
+            && (config.deadlocks || num_held == 0 || held[num_held - 1] < config.resources - 1);
+
+        instruction = (num_held > 0 && left <= num_held) ? REL_OP : gen_instr_type();
+        if (instruction == REQ_OP && !can_request) {
+            instruction = num_held > 0 ? REL_OP : -1;
+        } else if (instruction == REL_OP && num_held == 0) {
+            instruction = can_request ? REQ_OP : -1;
+        }
+        if (instruction == -1 && config.mailboxes > 0) {
+            instruction = gen_range(SEND_OP, RECV_OP);
+        }
 
-    for (int i = 0; i < num_instructions; i++) {
-        int instruction = random() % SUPPORTED_INSTR;
         switch (instruction) {
             case SEND_OP:
             case RECV_OP:
-                name = gen_name('m', rand() % num_mailboxes);
-                load_instruction(process_name, instruction, name, gen_msg(name));
+                mailbox = gen_range(0, config.mailboxes - 1);
+                load_instruction(process_name, instruction, mailbox_names[mailbox], mailbox_msgs[mailbox]);
                 break;
-            case REQ_OP:  
-                name = gen_name('R', rand() % num_resources);
-                load_instruction(process_name, instruction, name, NULL);
-                #ifdef RELEASE
-                if ((rand() % 2 == 1) && (++i < num_instructions)) {
-                    load_instruction(process_name, REL_OP, name, NULL);
-                }
-                #endif
+            case REQ_OP:
+                load_instruction(process_name, instruction, resource_names[gen_request()], NULL);
                 break;
-            case REL_OP:  
-                name = gen_name('R', rand() & num_resources);
-                load_instruction(process_name, instruction, name, NULL);
-            default: 
+            case REL_OP:
+                load_instruction(process_name, instruction, resource_names[gen_release()], NULL);
+                break;
+            default:
                 break;
         }
     }
+    end_instructions();
 #   ifdef DEBUG_LOADER
-    print_instr_list(process_name, NULL);    
+    if (get_verbosity() >= VERBOSE_DEBUG) {
+        print_instr_list(process_name, NULL);
+    }
 #   endif
 }
 
-int gen_prio(int *pr_alloc, int nth) {
-    int pr = 0;
-        pr = rand() % MAX_PROCS * 100 + 1; 
+/**
+ * @brief Picks a resource the process does not hold, above all it holds
+ *        unless the deadlocks setting is on, and adds it to the held resources.
+ */
+int gen_request() {
+    int resource;
+
+    if (config.deadlocks) {
+        /* a random resource, or the next one not held after it */
+        for (resource = gen_range(0, config.resources - 1); is_held[resource];
+                resource = (resource + 1) % config.resources);
+    } else {
+        resource = gen_range(num_held > 0 ? held[num_held - 1] + 1 : 0, config.resources - 1);
+    }
+    held[num_held++] = resource;
+    is_held[resource] = TRUE;
+    return resource;
+}
+
+/**
+ * @brief Picks one of the resources the process holds and removes it from
+ *        the held resources, keeping the others in order.
+ */
+int gen_release() {
+    int i = gen_range(0, num_held - 1), resource = held[i];
+
+    memmove(&held[i], &held[i + 1], (num_held - i - 1) * sizeof(int));
+    num_held--;
+    is_held[resource] = FALSE;
+    return resource;
+}
+
+/**
+ * @brief Returns the type of the next instruction; send and receive are only
+ *        generated if there are mailboxes, request and release only if there
+ *        are resources.
+ */
+int gen_instr_type() {
+    if (config.resources == 0) return gen_range(SEND_OP, RECV_OP);
+    if (config.mailboxes == 0) return gen_range(REQ_OP, REL_OP);
+    return gen_range(REQ_OP, RECV_OP);
+}
 
-    return pr;
+/**
+ * @brief Returns a random number drawn uniformly from lo .. hi
+ */
+int gen_range(int lo, int hi) {
+    /* xorshift64* */
+    rand_state ^= rand_state >> 12;
+    rand_state ^= rand_state << 25;
+    rand_state ^= rand_state >> 27;
+    if (hi <= lo) return lo;
+    return lo + (int) (((rand_state * 0x2545F4914F6CDD1Dull) >> 32) % ((uint64_t) hi - lo + 1));
 }
 
 /**
- * @brief Generates a name for a process, resource, or mailbox 
- * @return A pointer to a string for the name 
+ * @brief Generates a name for a process, resource, or mailbox
+ * @return A pointer to a string for the name
  */
 char* gen_name(char type, int id) {
-    char* name = calloc(MAX_NAME_SZ, sizeof(char));
-   
-    if (id < 10 * MAX_NAME_SZ) {
-        sprintf(name, "%c%d", type, id);
-    } else {
-        printf("Error: name too long: id >= %d \n", 10 * MAX_NAME_SZ);
-    }
+    char name[MAX_NAME_SZ];
 
-    return name;
+    snprintf(name, MAX_NAME_SZ, "%c%d", type, id);
+    return loader_strdup(name);
 }
 
 /**
- * @brief Generates a msg to send 
- * @return A pointer to a string for the msg 
+ * @brief Generates a msg to send
+ * @return A pointer to a string for the msg
  */
 char *gen_msg(char *mailbox) {
-    char* msg = calloc(MAX_MSG_SZ, sizeof(char));
-    
-    sprintf(msg, "Msg %s", mailbox);
-    return msg;
+    char msg[MAX_MSG_SZ];
+
+    snprintf(msg, MAX_MSG_SZ, "Msg %s", mailbox);
+    return loader_strdup(msg);
 }
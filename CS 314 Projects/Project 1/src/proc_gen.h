@@ -2,9 +2,32 @@
  * @file proc_gen.h
  */
 #ifndef GEN_H
-#define GEN_H 
+#define GEN_H
 
-bool_t generate_init_procs();
-bool_t generate_new_procs();
+#include "proc_structs.h"
+
+/** The shape of a generated workload, see configure_generator() */
+typedef struct gen_config_t {
+  unsigned long seed;  /* seed of the random generator, 0 to seed from the clock */
+  int init_procs;      /* processes in the ready queue when scheduling starts */
+  int new_procs;       /* processes that arrive during scheduling */
+  int resources;       /* resources R0 .. R<resources - 1> */
+  int instances;       /* instances per resource, drawn uniformly from 1 .. instances */
+  int mailboxes;       /* mailboxes m0 .. m<mailboxes - 1>; 0 generates no send or recv */
+  int min_instrs;      /* instructions per process, drawn uniformly */
+  int max_instrs;      /*   from min_instrs .. max_instrs */
+  int max_priority;    /* priorities drawn uniformly from 0 .. max_priority */
+  int arrival_gap;     /* (mean) ticks between bursts of arriving processes */
+  int burst;           /* processes per burst, drawn uniformly from 1 .. burst */
+  int poisson;         /* if not 0, gaps are exponential (Poisson arrivals), else fixed */
+  int deadlocks;       /* if not 0, resources are requested in random order, else ascending */
+  char *export_prefix; /* if not NULL, the workload is also written to <export_prefix>1.list and 2.list */
+} gen_config_t;
+
+void init_gen_config(gen_config_t *cfg);
+bool_t configure_generator(sim_t *sim, char *spec);
+gen_config_t *get_gen_config(sim_t *sim);
+bool_t generate_init_procs(sim_t *sim);
+bool_t generate_new_procs(sim_t *sim);
 
 #endif
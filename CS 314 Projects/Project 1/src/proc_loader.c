@@ -5,42 +5,89 @@
 #include "proc_parser.h"
 #include "proc_structs.h"
 #include "proc_gen.h"
+#include "proc_writer.h"
 #include "proc_syntax.h"
+#include "name_table.h"
+#include "arena.h"
+#include "logger.h"
 
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
 
-void dealloc_process_in_mem(process_in_mem_t *p);
-void dealloc_resource_list(resource_t *r);
-void dealloc_mailboxes();
 void dealloc_data_structures();
 
 void print_pcb_list(char *msg);
 void print_resource_list();
+void print_loaded(char *msg);
 void print_mailbox_list();
-void print_instr_list(char *msg, instr_t *nxt_instr);
+void print_instr_list(char *msg, process_in_mem_t *proc);
 
 void add_to_pcb_list(pcb_t *pcb); 
+void export_procs(int part, pcb_t *pcbs, resource_t *resources, mailbox_t *mailboxes);
+int intern_resource(char *resource_name);
+void index_pcb(pcb_t *pcb);
+pcb_t *find_pcb(char *process_name);
+bool_t stage_instruction(instr_types_t type, int id, char *msg);
+bool_t select_program(char *process_name);
 char *last_proc_name = "";
 int last_proc_num = 0;
 
 pcb_t *first_pcb = NULL;
 pcb_t *last_pcb = NULL;
 
+name_table_t proc_names; /* process name -> index into proc_table */
+pcb_t **proc_table = NULL; /* process name id -> pcb in the list being loaded, NULL if none */
+int proc_table_sz = 0;
+
 resource_t *first_resource = NULL;
 resource_t *last_resource = NULL;
 
-instr_t *first_instruction = NULL;
-instr_t *last_instruction = NULL;
+name_table_t resource_names; /* resource name -> resource id */
+resource_t **resource_table = NULL; /* resource id -> loaded resource, NULL until loaded */
+int resource_table_sz = 0;
+
+name_table_t mailbox_names; /* mailbox name -> mailbox id */
+
+/* The instructions of the process being loaded, copied into its
+ * process_in_mem by end_instructions() once they are all known */
+pcb_t *loading_pcb = NULL;
+unsigned char *staged_ops = NULL;
+int *staged_ids = NULL;
+char **staged_msgs = NULL;
+int num_staged = 0;
+int staged_sz = 0;
+int *staged_claim_ids = NULL;
+int *staged_claims = NULL;
+int num_staged_claims = 0;
+int staged_claims_sz = 0;
+process_in_mem_t *last_program = NULL; /* the program stored last, for print_instr_list() */
 
 mailbox_t *first_mailbox = NULL;
 mailbox_t *last_mailbox = NULL;
 
+static arena_t loader_arena; /* owns every pcb, instruction, resource, mailbox and generated name */
+
 void init_loader()
 {
-    last_proc_name = malloc(sizeof(char));
-    last_proc_name[0] = '\0';
+    last_proc_name = "";
+}
+
+/**
+ * @brief Allocates memory for a simulation object from the loader's arena.
+ *
+ * The memory is released, with everything else the loader owns, by
+ * dealloc_data_structures() and must not be freed on its own.
+ */
+void *loader_alloc(size_t size) {
+    return arena_alloc(&loader_arena, size);
+}
+
+/**
+ * @brief Returns a copy of <code>str</code> allocated from the loader's arena.
+ */
+char *loader_strdup(const char *str) {
+    return arena_strdup(&loader_arena, str);
 }
 
 /**
@@ -55,14 +102,12 @@ struct pcb_t *init_loader_from_files(char *filename1, char *filename2) {
     pcb_t *init_procs;
     bool_t success = parse_process_file(filename1);
     if (!success) printf("Error parsing %s\n", filename1);
-    print_pcb_list("Init processes");
-    print_resource_list();
+    print_loaded("Init processes");
     init_procs = get_init_pcbs();
 
     success = parse_process_file(filename2);
     if (!success) printf("Error parsing %s\n", filename2);
-    print_pcb_list("Arrival processes");
-    print_resource_list();
+    print_loaded("Arrival processes");
 
     return init_procs;
 }
@@ -80,41 +125,55 @@ struct pcb_t *init_loader_from_generator() {
     /* generate processes to initialise ready queue */ 
     int success = generate_init_procs();
     if (!success) printf("Error generating procs\n");
-    print_pcb_list("Init processes");
-    print_resource_list();
+    print_loaded("Init processes");
     init_pcbs = get_init_pcbs();
+    export_procs(1, init_pcbs, first_resource, first_mailbox);
  
     /* generate processes to arrive in ready queue during scheduling */ 
     success = generate_new_procs();
     if (!success) printf("Error generating procs\n");
-    print_pcb_list("Arrival processes");
-    print_resource_list();
+    print_loaded("Arrival processes");
+    export_procs(2, first_pcb, NULL, NULL);
 
     return init_pcbs; 
 }
 
+/**
+ * @brief Writes generated processes to a process file, if the generator was
+ *        configured to export them.
+ *
+ * @param part 1 for the initial processes, 2 for the arriving processes.
+ */
+void export_procs(int part, pcb_t *pcbs, resource_t *resources, mailbox_t *mailboxes) {
+    char *prefix = get_gen_config()->export_prefix;
+    char *filename;
+
+    if (prefix == NULL) return;
+    filename = malloc(strlen(prefix) + sizeof("1.list"));
+    sprintf(filename, "%s%d.list", prefix, part);
+    if (write_process_file(filename, pcbs, resources, mailboxes)) {
+        printf("Exported %s\n", filename);
+    }
+    free(filename);
+}
+
 /**
  * @brief Adds the new pcb to the list of pcbs 
  *
- * Adds a newly created pcb to the list of pcbs 
+ * Adds a newly created pcb to the end of the list of pcbs in O(1)
  *
  * @param the pcb to add
  */
 void add_to_pcb_list(pcb_t *new_pcb) {
-    pcb_t *current_pcb;
-
     if (first_pcb == NULL) {
         first_pcb = new_pcb;
     } else {
-        current_pcb = first_pcb;
-        while (current_pcb->next != NULL) {
-            current_pcb = current_pcb->next; 
-        }
-        current_pcb->next = new_pcb;
+        last_pcb->next = new_pcb;
     }
+    last_pcb = new_pcb;
 
     #ifdef DEBUG_LOADER
-        print_pcb_list("Loaded"); 
+        if (get_verbosity() >= VERBOSE_DEBUG) print_pcb_list("Loaded");
     #endif
 }
 
@@ -127,24 +186,45 @@ void add_to_pcb_list(pcb_t *new_pcb) {
  * NULL as well as setting the processState to NEW. 
  *
  * \param process_name The name of the new process to load
+ * \param priority The priority of the process
+ * \param arrival The tick at which the process arrives, or NO_ARRIVAL to let
+ *     the manager choose (see init_queues())
  */
-bool_t load_process(char* process_name, int priority) {
-    process_in_mem_t *new_process_in_mem = malloc(sizeof(process_in_mem_t));
+bool_t load_process(char* process_name, int priority, long arrival) {
+    process_in_mem_t *new_process_in_mem = loader_alloc(sizeof(process_in_mem_t));
 
     pcb_t *pcb = NULL;
     if (new_process_in_mem) {
-        pcb = malloc(sizeof(pcb_t));
+        pcb = loader_alloc(sizeof(pcb_t));
         pcb->process_in_mem = new_process_in_mem;
         pcb->state = NEW;
-        pcb->next_instruction = NULL;
+        pcb->pc = 0;
         pcb->priority = priority;
+        pcb->arrival = arrival;
+        pcb->first_run = NO_TICK;
+        pcb->ready_since = 0;
+        pcb->wait = 0;
+        pcb->completion = NO_TICK;
+        pcb->cpu = NO_CPU;
+        pcb->vruntime = 0;
+        pcb->tree_left = pcb->tree_right = pcb->tree_parent = NULL;
+        pcb->tree_red = FALSE;
+        pcb->tree_seq = 0;
         pcb->resources = NULL;
         pcb->next = NULL;
 
         pcb->process_in_mem->name = process_name;
         pcb->process_in_mem->number = ++last_proc_num;
+        pcb->process_in_mem->num_instrs = 0;
+        pcb->process_in_mem->ops = NULL;
+        pcb->process_in_mem->ids = NULL;
+        pcb->process_in_mem->msgs = NULL;
+        pcb->process_in_mem->num_claims = 0;
+        pcb->process_in_mem->claim_ids = NULL;
+        pcb->process_in_mem->claims = NULL;
 
         add_to_pcb_list(pcb);
+        index_pcb(pcb);
     } 
     
     if (pcb) return TRUE;
@@ -159,7 +239,7 @@ bool_t load_process(char* process_name, int priority) {
  * @param mailbox_name The name of the mailbox to load.
  */
 bool_t load_mailbox(char* mailbox_name) {
-    mailbox_t *tmp_mailbox = malloc(sizeof(mailbox_t));
+    mailbox_t *tmp_mailbox = loader_alloc(sizeof(mailbox_t));
     int success = TRUE;  
  
     if (tmp_mailbox) {
@@ -172,31 +252,106 @@ bool_t load_mailbox(char* mailbox_name) {
             last_mailbox = tmp_mailbox;
         }
         last_mailbox->name = mailbox_name;
+        last_mailbox->msg = NULL;
+        intern_name(&mailbox_names, mailbox_name);
         last_mailbox->next = NULL;
     } else {
         success = FALSE;
     } 
    
  #ifdef DEBUG_LOADER
-     printf("Added %s; ", mailbox_name);
-     print_mailbox_list();
+     if (get_verbosity() >= VERBOSE_DEBUG) {
+         printf("Added %s; ", mailbox_name);
+         print_mailbox_list();
+     }
  #endif
  
  return success;
 }
 
+/**
+ * @brief Returns the id of a resource name, interning it if it is new.
+ *
+ * Instructions may name a resource that is declared later, or never, so ids
+ * are handed out on first sight of a name and the resource table is grown to
+ * cover them.
+ *
+ * @param resource_name The name of the resource.
+ */
+int intern_resource(char *resource_name) {
+    int id = intern_name(&resource_names, resource_name);
+    int new_sz;
+
+    if (id >= resource_table_sz) {
+        new_sz = resource_table_sz ? 2 * resource_table_sz : 16;
+        resource_table = realloc(resource_table, new_sz * sizeof(resource_t *));
+        memset(resource_table + resource_table_sz, 0, 
+            (new_sz - resource_table_sz) * sizeof(resource_t *));
+        resource_table_sz = new_sz;
+    }
+    return id;
+}
+
+/**
+ * @brief Makes a loaded pcb findable by the name of its process.
+ *
+ * If the list being loaded already holds a process with the same name, the
+ * first one keeps the name.
+ *
+ * @param pcb The pcb that was added to the list of pcbs.
+ */
+void index_pcb(pcb_t *pcb) {
+    int id = intern_name(&proc_names, pcb->process_in_mem->name);
+    int new_sz;
+
+    if (id >= proc_table_sz) {
+        new_sz = proc_table_sz ? 2 * proc_table_sz : 64;
+        while (new_sz <= id) new_sz *= 2;
+        proc_table = realloc(proc_table, new_sz * sizeof(pcb_t *));
+        memset(proc_table + proc_table_sz, 0, 
+            (new_sz - proc_table_sz) * sizeof(pcb_t *));
+        proc_table_sz = new_sz;
+    }
+    if (proc_table[id] == NULL) proc_table[id] = pcb;
+}
+
+/**
+ * @brief Returns the pcb of process <code>process_name</code> in the list
+ *        being loaded, or NULL if there is no such process, in O(1).
+ */
+pcb_t *find_pcb(char *process_name) {
+    int id = find_name(&proc_names, process_name);
+
+    if (id == NO_ID || id >= proc_table_sz) return NULL;
+    return proc_table[id];
+}
+
 /**
  * @brief Loads a resource from the process.list file.
  *
  * Loads a resource and adds it to the list of resources. The resource
- * is indicated as available and the resource name is stored.
+ * is indicated as available and the resource name is stored. A resource
+ * whose name was already loaded is ignored.
  *
  * @param resource_name The name of the resource to load.
+ * @param instances The number of instances of the resource, at least 1.
  */
-bool_t load_resource(char *resource_name) {
-    resource_t *tmp_resource = malloc(sizeof(resource_t));
+bool_t load_resource(char *resource_name, int instances) {
+    resource_t *tmp_resource;
     bool_t success = TRUE;  
+    int id = intern_resource(resource_name);
+
+    if (resource_table[id] != NULL) {
+#ifdef DEBUG_LOADER
+        if (get_verbosity() >= VERBOSE_DEBUG) {
+            printf("Duplicate %s ignored; ", resource_name);
+            print_resource_list();
+        }
+#endif
+        return success;
+    }
  
+    tmp_resource = loader_alloc(sizeof(resource_t));
     if (tmp_resource) {
         if (first_resource == NULL) {
             first_resource = tmp_resource; 
@@ -206,14 +361,19 @@ bool_t load_resource(char *resource_name) {
             last_resource = tmp_resource;
         }
         last_resource->name = resource_name;
+        last_resource->id = id;
         last_resource->available = YES;
+        last_resource->instances = (instances > 1) ? instances : 1;
+        resource_table[id] = last_resource;
         last_resource->next = NULL;
     } else {
         success = FALSE;
     }
 #ifdef DEBUG_LOADER
-    printf("Added %s; ", resource_name);
-    print_resource_list();
+    if (get_verbosity() >= VERBOSE_DEBUG) {
+        printf("Added %s; ", resource_name);
+        print_resource_list();
+    }
 #endif
 
     return success;
@@ -225,7 +385,9 @@ bool_t load_resource(char *resource_name) {
  *
  * The function uses the process_name to locate the process for 
  * which the instruction should be loaded as well as the resource
- * on which the action is performed.
+ * on which the action is performed. The instructions of a process are
+ * collected until the instructions of another process are loaded or
+ * end_instructions() is called, and are then stored as its program.
  *
  * @param process_name The name of the process for which to load the
  * instruction.
@@ -234,50 +396,146 @@ bool_t load_resource(char *resource_name) {
  */
 bool_t load_instruction(char *process_name, instr_types_t instruction, 
     char *resource_name, char *msg) {
-    bool_t success = TRUE;
+    if (!select_program(process_name)) {
+        fprintf(stderr, "Instruction of unknown process %s ignored\n", process_name);
+        return FALSE;
+    }
 
-    instr_t *tmp_instr = malloc(sizeof(struct instr_t));
-    pcb_t *pcb = NULL;
+    switch (instruction) {
+    case SEND_OP: 
+    case RECV_OP: 
+        return stage_instruction(instruction, intern_name(&mailbox_names, resource_name), msg);
+    default: 
+        return stage_instruction(instruction, intern_resource(resource_name), NULL);
+    }
+}
 
-    if (tmp_instr) { 
-        if (strcmp(last_proc_name, process_name) != 0) {
-            first_instruction = tmp_instr; 
-            first_instruction->next = NULL;
-            last_instruction = first_instruction;
-        } else {
-            tmp_instr->next = NULL;
-            last_instruction->next = tmp_instr;
-            last_instruction = tmp_instr;
-        }
-    
-        last_instruction->resource_name = resource_name;
-        switch (instruction) {
-        case SEND_OP: 
-        case RECV_OP: 
-            last_instruction->type = instruction; 
-            last_instruction->msg = msg;
-            break;
-        default: 
-            last_instruction->type = instruction;
-            last_instruction->msg = NULL;
-            break;
-        }
+/**
+ * @brief Loads a maximum claim of a process: the most instances of
+ *        <code>resource_name</code> it holds at once. Used by the Banker's
+ *        deadlock avoidance of the manager; a resource the process requests
+ *        without a claim is claimed as often as it is requested.
+ */
+bool_t load_claim(char *process_name, char *resource_name, int claim) {
+    int new_sz;
 
-        pcb = first_pcb;
-        if (pcb != NULL) {
-            do { 
-                if(strcmp(pcb->process_in_mem->name, process_name) == 0) break;
-                pcb = pcb->next;
-            } while (pcb != NULL); 
-            pcb->next_instruction = first_instruction;
-            pcb->process_in_mem->first_instr = first_instruction;
-        }
+    if (!select_program(process_name)) {
+        fprintf(stderr, "Claim of unknown process %s ignored\n", process_name);
+        return FALSE;
+    }
+
+    if (num_staged_claims == staged_claims_sz) {
+        new_sz = staged_claims_sz ? 2 * staged_claims_sz : 8;
+        staged_claim_ids = realloc(staged_claim_ids, new_sz * sizeof(int));
+        staged_claims = realloc(staged_claims, new_sz * sizeof(int));
+        if (!staged_claim_ids || !staged_claims) return FALSE;
+        staged_claims_sz = new_sz;
+    }
+    staged_claim_ids[num_staged_claims] = intern_resource(resource_name);
+    staged_claims[num_staged_claims] = claim;
+    num_staged_claims++;
+    return TRUE;
+}
+
+/**
+ * @brief Makes <code>process_name</code> the process whose program is being
+ *        loaded, storing the program of the previous one.
+ *
+ * @return FALSE if no such process was loaded
+ */
+bool_t select_program(char *process_name) {
+    pcb_t *pcb;
+
+    if (strcmp(last_proc_name, process_name) != 0) {
+        end_instructions();
+
+        pcb = find_pcb(process_name);
+        if (pcb == NULL) return FALSE;
+        loading_pcb = pcb;
         last_proc_name = process_name; 
-    } else {
-        success = FALSE;
     }
+    return TRUE;
+}
 
-    return success;
+/**
+ * @brief Appends an instruction to the instructions of the process being loaded.
+ */
+bool_t stage_instruction(instr_types_t type, int id, char *msg) {
+    int new_sz;
+
+    if (num_staged == staged_sz) {
+        new_sz = staged_sz ? 2 * staged_sz : 64;
+        staged_ops = realloc(staged_ops, new_sz * sizeof(unsigned char));
+        staged_ids = realloc(staged_ids, new_sz * sizeof(int));
+        staged_msgs = realloc(staged_msgs, new_sz * sizeof(char *));
+        if (!staged_ops || !staged_ids || !staged_msgs) return FALSE;
+        staged_sz = new_sz;
+    }
+
+    staged_ops[num_staged] = type;
+    staged_ids[num_staged] = id;
+    staged_msgs[num_staged] = msg;
+    num_staged++;
+    return TRUE;
+}
+
+/**
+ * @brief Stores the instructions loaded for the last process as its program.
+ *
+ * The instructions are copied into arrays of exactly the right size in the
+ * loader's arena. If the process already had a program, because its
+ * instructions are split over several blocks of the input, the new
+ * instructions and claims are appended to it. The name of the process is
+ * forgotten so that its next instructions start a new block.
+ */
+void end_instructions() {
+    process_in_mem_t *proc;
+    unsigned char *ops;
+    int *ids, *claim_ids, *claims;
+    char **msgs;
+    int n, num_claims;
+
+    if (loading_pcb != NULL) {
+        proc = loading_pcb->process_in_mem;
+        n = proc->num_instrs;
+        ops = loader_alloc((n + num_staged) * sizeof(unsigned char));
+        ids = loader_alloc((n + num_staged) * sizeof(int));
+        msgs = loader_alloc((n + num_staged) * sizeof(char *));
+        if (n > 0) {
+            memcpy(ops, proc->ops, n * sizeof(unsigned char));
+            memcpy(ids, proc->ids, n * sizeof(int));
+            memcpy(msgs, proc->msgs, n * sizeof(char *));
+        }
+        memcpy(ops + n, staged_ops, num_staged * sizeof(unsigned char));
+        memcpy(ids + n, staged_ids, num_staged * sizeof(int));
+        memcpy(msgs + n, staged_msgs, num_staged * sizeof(char *));
+        proc->ops = ops;
+        proc->ids = ids;
+        proc->msgs = msgs;
+        proc->num_instrs = n + num_staged;
+
+        if (num_staged_claims > 0) {
+            num_claims = proc->num_claims;
+            claim_ids = loader_alloc((num_claims + num_staged_claims) * sizeof(int));
+            claims = loader_alloc((num_claims + num_staged_claims) * sizeof(int));
+            if (num_claims > 0) {
+                memcpy(claim_ids, proc->claim_ids, num_claims * sizeof(int));
+                memcpy(claims, proc->claims, num_claims * sizeof(int));
+            }
+            memcpy(claim_ids + num_claims, staged_claim_ids, num_staged_claims * sizeof(int));
+            memcpy(claims + num_claims, staged_claims, num_staged_claims * sizeof(int));
+            proc->claim_ids = claim_ids;
+            proc->claims = claims;
+            proc->num_claims = num_claims + num_staged_claims;
+        }
+        loading_pcb->pc = 0;
+        last_program = proc;
+    }
+
+    loading_pcb = NULL;
+    num_staged = 0;
+    num_staged_claims = 0;
+    last_proc_name = "";
 }
 
 /**
@@ -289,6 +547,8 @@ pcb_t *get_init_pcbs() {
     pcb_t *loaded_pcbs = first_pcb;
     first_pcb = NULL;
     last_pcb = NULL;
+    /* instructions that follow belong to the processes loaded next */
+    if (proc_table) memset(proc_table, 0, proc_table_sz * sizeof(pcb_t *));
     return loaded_pcbs;
 }
 
@@ -303,7 +563,8 @@ pcb_t *get_new_pcb() {
     if (new_pcb) { /* at least one pcb left */
         first_pcb = first_pcb->next;
         new_pcb->next = NULL;
-    } else { /* pcb list empty */ 
+    }
+    if (first_pcb == NULL) { /* pcb list empty */ 
         last_pcb = NULL;
     }
     return new_pcb;
@@ -321,161 +582,138 @@ struct resource_t *get_available_resources() {
 }
 
 /**
- * @brief Returns the first pointer to the available mailboxes.
- *
- * Returns the first pointer to the available mailboxes.
+ * @brief Returns the loaded resource with the given id in O(1).
  *
- * @return first_mailbox Pointer to the mailbox list.
+ * @param id A resource id, as stored in process_in_mem_t and resource_t.
+ * @return The resource, or NULL if no resource with that id was loaded.
  */
-struct mailbox_t* get_mailboxes() {
-    return first_mailbox;
+struct resource_t *get_resource(int id) {
+    if (id < 0 || id >= resource_table_sz) return NULL;
+    return resource_table[id];
 }
 
 /**
- * @brief Returns the number of processes created 
- *
- * @return last_proc_num: id assigned to the last process  
+ * @brief Returns the number of resource ids handed out so far.
  */
-int get_num_procs() {
-    return last_proc_num;
+int get_num_resource_ids() {
+    return resource_names.num_names;
 }
+
 /**
- * @brief Frees the allocated memory for the process_in_mem struct.
- *
- * Frees the name stored in the structed followed by the struct.
+ * @brief Returns the name of the resource with the given id, whether or not
+ *        a resource with that name was loaded.
  */
-void dealloc_process_in_mem(struct process_in_mem_t *p) {
-    if (p != NULL) {
-        free(p->name);
-        free(p);
-    }
+char *get_resource_name(int id) {
+    return get_name(&resource_names, id);
 }
 
 /**
- * @brief Frees the allocated memory for the instruction struct.
+ * @brief Returns the name of the mailbox with the given id.
  *
- * Frees the instruction struct.
+ * @param id A mailbox id, as stored for send and receive instructions.
  */
-void dealloc_instruction(struct instr_t *i) {
-    if(i != NULL) {
-        free(i);
-    }
+char *get_mailbox_name(int id) {
+    return get_name(&mailbox_names, id);
 }
 
 /**
- * @brief Frees the resources used in the system.
- *
- * Frees a linked list of resources 
+ * @brief Returns the number of mailbox ids handed out so far, for mailboxes
+ *        declared or only named by a send or receive instruction.
  */
-void dealloc_resource_list(resource_t *r) {
-    resource_t *current_resource;
-    resource_t *next_resource;
-
-    if (r != NULL) {
-        current_resource = r;
-        do {
-            next_resource = current_resource->next;
-            free(current_resource);
-            current_resource = next_resource;
-        } while (current_resource != NULL);
-    }
+int get_num_mailbox_ids() {
+    return mailbox_names.num_names;
 }
 
 /**
- * @brief Frees all the memory allocated for a linked list of PCBs.
+ * @brief Returns the first pointer to the available mailboxes.
+ *
+ * Returns the first pointer to the available mailboxes.
  *
- * Iterates over the loaded process PCBs, starting from current_pcb, freeing all the
- * allocated memory assigned to each process.
+ * @return first_mailbox Pointer to the mailbox list.
  */
-void dealloc_pcb_list(pcb_t *current_pcb) {    
-    pcb_t *next_pcb;
-    instr_t *instruction;
-    instr_t *next_instruction;
-
-    if (current_pcb != NULL) {
-
-        do {
-            instruction = current_pcb->process_in_mem->first_instr;
-
-            while (instruction != NULL) {
-                next_instruction = instruction->next;
-                dealloc_instruction(instruction);
-                instruction = next_instruction;
-            }
-
-            dealloc_process_in_mem(current_pcb->process_in_mem);
-
-            next_pcb = current_pcb->next;
-            free(current_pcb);
-            current_pcb = next_pcb;
-        } while(current_pcb != NULL);
-    }
+struct mailbox_t* get_mailboxes() {
+    return first_mailbox;
 }
 
-
 /**
- * @brief Frees the mailboxes used in the system.
+ * @brief Returns the number of processes created 
  *
- * Free each of the mailboxes which are available and used in the system.
+ * @return last_proc_num: id assigned to the last process  
  */
-void dealloc_mailboxes() {
-    mailbox_t *current_mailbox;
-    mailbox_t *next_mailbox;
-    
-    current_mailbox = get_mailboxes();
-    if(current_mailbox != NULL) {
-        do {
-            free(current_mailbox->name);
-            if(current_mailbox->msg != NULL) {
-                free(current_mailbox->msg);
-            }
-            next_mailbox = current_mailbox->next;
-            free(current_mailbox);
-            current_mailbox = next_mailbox;
-        } while (current_mailbox != NULL);
-    }
+int get_num_procs() {
+    return last_proc_num;
 }
-
 /**
  * @brief Frees the memory for all the data structures 
  *
+ * Every pcb, instruction, resource and mailbox was carved from the loader's
+ * arena, so they are all released at once, wherever they are queued.
  */
 void dealloc_data_structures() {
-    resource_t *availableResources;
-    pcb_t *pcbs;
-
-    /* Frees the memory for resources not assigned to processes */
-    availableResources = get_available_resources();
-    dealloc_resource_list(availableResources);
-    pcbs = first_pcb;
-    dealloc_pcb_list(pcbs);
-    dealloc_mailboxes();
+    first_pcb = NULL;
+    last_pcb = NULL;
+    first_resource = NULL;
+    last_resource = NULL;
+    first_mailbox = NULL;
+    last_mailbox = NULL;
+    loading_pcb = NULL;
+    last_program = NULL;
+    free(staged_ops);
+    free(staged_ids);
+    free(staged_msgs);
+    staged_ops = NULL;
+    staged_ids = NULL;
+    staged_msgs = NULL;
+    num_staged = 0;
+    staged_sz = 0;
+    free(staged_claim_ids);
+    free(staged_claims);
+    staged_claim_ids = NULL;
+    staged_claims = NULL;
+    num_staged_claims = 0;
+    staged_claims_sz = 0;
+
+    free(proc_table);
+    proc_table = NULL;
+    proc_table_sz = 0;
+    free_name_table(&proc_names);
+    free(resource_table);
+    resource_table = NULL;
+    resource_table_sz = 0;
+    free_name_table(&resource_names);
+    free_name_table(&mailbox_names);
+    free_arena(&loader_arena);
+    free_process_files();
 }
 
 /**
- * @brief Frees the allocated memory for the process_in_mem struct.
+ * @brief Prints the loaded processes and resources, unless the verbosity
+ *        level is below VERBOSE_EVENTS.
  */
-void dealloc_last_proc_name() {
-    free(last_proc_name);
+void print_loaded(char *msg) {
+    if (get_verbosity() < VERBOSE_EVENTS) return;
+    print_pcb_list(msg);
+    print_resource_list();
 }
 
 void print_pcb_list(char *msg) {
     pcb_t *current_pcb = first_pcb;
     printf("%s: ", msg);
-    do {
+    while (current_pcb != NULL) {
         printf("%s (%d) ", current_pcb->process_in_mem->name, current_pcb->priority);
         current_pcb = current_pcb->next;
-    } while(current_pcb != NULL);
+    }
     printf("\n");
 }
 
 void print_resource_list() {
     resource_t *current_resource = first_resource;
     printf("Resources: ");
-    do {
+    while (current_resource != NULL) {
         printf("%s ", current_resource->name);
+        if (current_resource->instances > 1) printf("(%d) ", current_resource->instances);
         current_resource = current_resource->next;
-    } while(current_resource != NULL);
+    }
     printf("\n");
 }
 
@@ -483,20 +721,23 @@ void print_mailbox_list() {
     mailbox_t *current_mailbox;
     current_mailbox = first_mailbox;
     printf("mailboxes : ");
-    do {
+    while (current_mailbox != NULL) {
         printf("%s ", current_mailbox->name);
         current_mailbox = current_mailbox->next;
-    } while(current_mailbox != NULL);
+    }
     printf("\n");
 }
 
-void print_instr_list(char *msg, instr_t *nxt_instr) {
-    instr_t *cur_instr = nxt_instr;
-    if (nxt_instr == NULL) cur_instr = first_instruction;
+void print_instr_list(char *msg, process_in_mem_t *proc) {
+    int i;
+    if (proc == NULL) proc = last_program;
     printf("%s: ", msg);
-    while (cur_instr != NULL) {
-        printf("%s %s\n    ", (cur_instr->type == REQ_OP)?"req":"rel", cur_instr->resource_name);
-        cur_instr = cur_instr->next;
+    for (i = 0; proc != NULL && i < proc->num_instrs; i++) {
+        if (proc->ops[i] == REQ_OP || proc->ops[i] == REL_OP) {
+            printf("%s %s\n    ", (proc->ops[i] == REQ_OP)?"req":"rel", get_resource_name(proc->ids[i]));
+        } else {
+            printf("%s %s\n    ", (proc->ops[i] == SEND_OP)?"send":"recv", get_mailbox_name(proc->ids[i]));
+        }
     } 
     printf("\n");
 } 
@@ -1,36 +1,56 @@
 /**
  * @file parser.c
+ *
+ * The process file is memory-mapped (privately, so changes are not written
+ * back) and tokenised in place in a single pass: every name, resource and
+ * message handed to the loader is a pointer into the mapping, terminated by
+ * overwriting the delimiter that follows it with '\0'. No memory is allocated
+ * per token. The mappings stay alive until free_process_files() is called.
  */
-#include <stdio.h> 
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
 #include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #include "proc_syntax.h"
-#include "proc_parser.h" 
+#include "proc_parser.h"
 #include "proc_structs.h"
-
-#define READING 0
-#define END_OF_FILE 2
-#define NAME_SZ 5
-
-FILE *open_process_file(char *filename);
-bool_t read_processes(FILE *fptr, char *line);
-bool_t read_resources(FILE *fptr, char *line);
-bool_t read_mailboxes(FILE *fptr, char *line);
-int read_process(FILE *fptr, char *line);
-void read_req_resource(FILE *fptr, char *line);
-void read_rel_resource(FILE *fptr, char *line);
-char *read_comms_send(FILE *fptr, char *line);
-char *read_comms_recv(FILE *fptr, char *line);
-int read_string(FILE *fptr, char *line);
-unsigned short int read_number(FILE *fptr, int *number);
-bool_t str_to_priority(char *string, int *priority);
+#include "logger.h"
+
+/** A process file held in memory, either mapped or read into a buffer */
+typedef struct process_file_t {
+    char *buf;
+    size_t len;     /* bytes of buf that may be accessed */
+    bool_t mapped;  /* TRUE if buf must be munmap'ed rather than freed */
+    struct process_file_t *next;
+} process_file_t;
+
+/** A cursor over one line of the file */
+typedef struct line_t {
+    char *pos;
+    char *end;      /* the '\n' (or end of file) that ends the line */
+} line_t;
+
+static process_file_t *process_files = NULL;
+
+process_file_t *open_process_file(char *filename);
+char *next_line(char **pos, char *end, line_t *line);
+char *next_token(line_t *line);
+bool_t read_processes(line_t *line);
+bool_t read_resources(line_t *line);
+bool_t read_mailboxes(line_t *line);
+void read_comms(line_t *line, char *process_name, instr_types_t type);
+void read_claim(line_t *line, char *process_name, char *resource_name);
+bool_t str_to_int(char *string, int *value);
 
 /**
  * @brief Reads in a specified file, parse it and store it in the associated data-structure.
- * 
+ *
  * Reads the process.list file and parse it. It reads the processes and
  * continues by reading the resources. Next the function looks for the process
  * setup and reads the request and release statements. At each stage of the
@@ -39,473 +59,355 @@ bool_t str_to_priority(char *string, int *priority);
  * @param filename A string with the location of the process.list file for reading.
  */
 int parse_process_file(char *filename) {
-    FILE *fptr = NULL;
-    char line[1024];
-    int status;
-    int success = FALSE;
+    process_file_t *file;
+    line_t line;
+    char *pos, *end, *keyword, *token;
+    char *process_name = NULL;
 
-    fptr = open_process_file(filename);
-
-    if (fptr == NULL) {
+    file = open_process_file(filename);
+    if (file == NULL) {
         printf("File is NULL. Exiting.");
-        success = FALSE;
-    } else {
-
-        init_loader();
-    
-        read_string(fptr, line);
-        if (read_processes(fptr, line)) read_string(fptr, line);
-        if (read_resources(fptr, line)) read_string(fptr, line);
-        if (read_mailboxes(fptr, line)) read_string(fptr, line); 
-        /* Skip all the whitespaces of the next line */
-        if (strcmp(line, "") == 0) read_string(fptr, line);
-
-        /* Read the list of instructions listed for each process */
-        status = READING;
-        while (status != END_OF_FILE) status = read_process(fptr, line); 
-
-        dealloc_last_proc_name();
-        fclose(fptr);
-        success = TRUE;
+        return FALSE;
     }
-    return success;
+
+    init_loader();
+
+    pos = file->buf;
+    end = file->buf + file->len - 1; /* the last byte is reserved for a '\0' */
+    while ((keyword = next_line(&pos, end, &line)) != NULL) {
+        if (strcmp(keyword, PROCESSES) == 0) {
+            read_processes(&line);
+        } else if (strcmp(keyword, RESOURCES) == 0) {
+            read_resources(&line);
+        } else if (strcmp(keyword, MAILBOXES) == 0) {
+            read_mailboxes(&line);
+        } else if (strcmp(keyword, PROCESS) == 0) {
+            /* the instructions that follow belong to this process */
+            process_name = next_token(&line);
+#ifdef DEBUG_LOADER
+            if (get_verbosity() >= VERBOSE_DEBUG) printf("Process %s\n", process_name);
+#endif
+        } else if (process_name == NULL) {
+            fprintf(stderr, "%s: instruction %s outside a process\n", filename, keyword);
+        } else if (strcmp(keyword, REQ) == 0 && (token = next_token(&line)) != NULL) {
+#ifdef DEBUG_LOADER
+            if (get_verbosity() >= VERBOSE_DEBUG) printf("req %s\n", token);
+#endif
+            load_instruction(process_name, REQ_OP, token, NULL);
+        } else if (strcmp(keyword, REL) == 0 && (token = next_token(&line)) != NULL) {
+#ifdef DEBUG_LOADER
+            if (get_verbosity() >= VERBOSE_DEBUG) printf("rel %s\n", token);
+#endif
+            load_instruction(process_name, REL_OP, token, NULL);
+        } else if (strcmp(keyword, SEND) == 0) {
+            read_comms(&line, process_name, SEND_OP);
+        } else if (strcmp(keyword, RECV) == 0) {
+            read_comms(&line, process_name, RECV_OP);
+        } else if (strcmp(keyword, CLAIM) == 0 && (token = next_token(&line)) != NULL) {
+            read_claim(&line, process_name, token);
+        } else {
+            fprintf(stderr, "%s: unknown statement %s\n", filename, keyword);
+        }
+    }
+
+    end_instructions();
+    return TRUE;
 }
 
 /**
- * @brief Opens the file with filename and return a pointer to the file.
+ * @brief Maps the file with filename into memory.
  *
- * Opens a file, with filename, for read-only. If the file could not be
- * open return NULL else return the pointer to the file.
+ * The file is mapped privately and writable so that tokens can be terminated
+ * in place. One byte past the end of the file is needed for the '\0' of the
+ * last token; when the file fills its last page exactly that byte would lie
+ * outside the mapping, so such files are read into a buffer instead.
  *
  * @param filename The name of the file to open
  *
- * @return A file pointer
+ * @return The file in memory, or NULL if it could not be opened
  */
-FILE *open_process_file(char *filename) {
+process_file_t *open_process_file(char *filename) {
+    process_file_t *file;
+    struct stat st;
+    long page_sz = sysconf(_SC_PAGESIZE);
+    int fd = open(filename, O_RDONLY);
 
-    FILE *file = fopen(filename, "r"); 
-
-    if (file == NULL) {
+    if (fd < 0 || fstat(fd, &st) < 0) {
         fprintf(stderr, "Error opening %s\n", filename);
+        if (fd >= 0) close(fd);
+        return NULL;
+    }
+
+    file = malloc(sizeof(process_file_t));
+    file->len = st.st_size + 1;
+    file->mapped = FALSE;
+    file->buf = NULL;
+
+    if (st.st_size > 0 && st.st_size % page_sz != 0) {
+        file->buf = mmap(NULL, file->len, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        if (file->buf == MAP_FAILED) file->buf = NULL;
+        else file->mapped = TRUE;
     }
 
+    if (file->buf == NULL) {
+        file->buf = malloc(file->len);
+        if (file->buf == NULL || read(fd, file->buf, st.st_size) != st.st_size) {
+            fprintf(stderr, "Error reading %s\n", filename);
+            free(file->buf);
+            free(file);
+            close(fd);
+            return NULL;
+        }
+    }
+    file->buf[st.st_size] = '\0';
+    close(fd);
+
+    file->next = process_files;
+    process_files = file;
     return file;
 }
 
 /**
- * @brief Reads a number from a file.
+ * @brief Frees the memory of all the parsed process files.
  *
- * @param fptr pointer to the file
- * @param number pointer to the number to be read
- *
- * @return TRUE if a newline was reached after reading the number
+ * Must only be called once the names that were loaded are no longer used.
  */
-unsigned short int read_number(FILE *fptr, int *number)
-{
-    int digit, ch;
-
-    *number = 0;
-    while ((ch = fgetc(fptr)) && isdigit(ch)) {
-        digit = atoi((char *) &ch);
-        if (*number > (INT_MAX - digit) / 10) {
-            fprintf(stderr, "number too large");
-        } else {
-            *number = 10 * *number + digit;
-        }
+void free_process_files() {
+    process_file_t *next;
+
+    while (process_files != NULL) {
+        next = process_files->next;
+        if (process_files->mapped) munmap(process_files->buf, process_files->len);
+        else free(process_files->buf);
+        free(process_files);
+        process_files = next;
     }
-    return (ch != '\n');
 }
 
 /**
- * @brief Converts string to an integer if it is a number 
+ * @brief Moves to the next non-empty line and returns its first token.
  *
- * @param the string 
- * @param the integer value of the number represented by string if it is a number  
+ * @param pos The current position in the file, moved past the line.
+ * @param end The end of the file.
+ * @param line Set to the rest of the line after the first token.
  *
- * @return TRUE if string is a number, else FALSE 
+ * @return The first token, or NULL at the end of the file.
  */
-bool_t str_to_priority(char *string, int *priority)
-{
-    bool_t success = TRUE;
-
-    if ((isdigit(string[0]) && strlen(string) < NAME_SZ)) *priority = atoi(string);
-    else {
-        printf("Priority to high %s\n", string); 
-        success = FALSE; 
+char *next_line(char **pos, char *end, line_t *line) {
+    char *token = NULL;
+
+    while (token == NULL && *pos < end) {
+        line->pos = *pos;
+        line->end = memchr(*pos, '\n', end - *pos);
+        if (line->end == NULL) line->end = end;
+        *pos = line->end + 1;
+        token = next_token(line);
     }
-
-    return success;
+    return token;
 }
 
 /**
- * @brief Reads the list of processes and loads it with functions defined in 
- *     data_structs.h
+ * @brief Returns the next whitespace-separated token of the line.
  *
- * Reads a line from the file referenced by fptr and expects it to be the
- * PROCESSES keyword. If true continue to reserve space for the process name
- * and repeatedly read all the processes and load it.
+ * The token is terminated in place by overwriting the character after it.
  *
- * Custom change: Reads in prioriy. Unfortunately segfaults if priority is not
- * present (but it was promised to always be present).    
+ * @param line The line, moved past the token.
  *
- * @param fptr A pointer to the file from which to read.
- * @param line A pointer to a string read from the file.
+ * @return The token, or NULL if the line has no more tokens.
  */
-bool_t read_processes(FILE *fptr, char *line) {
-    char *process_name, *nxt_string;
-    int priority, not_eol;
-    bool_t success = TRUE;
-
-    /* If process list provided */
-    if (strcmp(line, PROCESSES) == 0) {
-        /* Read next string: process name */ 
-        process_name = malloc(NAME_SZ * sizeof(char));
-        not_eol = read_string(fptr, process_name);
-        while (not_eol) {
-            priority = 0;
-           /* Read next string: priority or next process name */ 
-            nxt_string = malloc(NAME_SZ * sizeof(char));
-            not_eol = read_string(fptr, nxt_string); 
-            if (nxt_string != NULL) {
-               /* If string read was a priority: assign to variable */ 
-                if (str_to_priority(nxt_string, &priority)) {
-                    /* If string read was not the end of the line */
-                    if (not_eol) { 
-                        /* Read next string: process name */ 
-                        nxt_string = malloc(NAME_SZ * sizeof(char));
-                        not_eol = read_string(fptr, nxt_string); 
-                    }
-                } else {
-                    printf("no priority\n");
-                }
-            }
-            load_process(process_name, priority);
-            /* Assing process name */ 
-            process_name = nxt_string; 
-        }
-        success = TRUE;
-    } else {
-        printf("No process list provided\n"); 
-        success = FALSE;
-    }
-    return success;
+char *next_token(line_t *line) {
+    char *token;
+
+    while (line->pos < line->end && isspace((unsigned char) *line->pos)) line->pos++;
+    if (line->pos >= line->end) return NULL;
+
+    token = line->pos;
+    while (line->pos < line->end && !isspace((unsigned char) *line->pos)) line->pos++;
+    *line->pos = '\0';
+    if (line->pos < line->end) line->pos++;
+
+    return token;
 }
 
 /**
- * @brief Reads the list of resources and loads it with functions defined in 
- *    data_structs.h
+ * @brief Converts string to an integer if it is a number
  *
- * Reads the list of resources and loads it with the load_resource function
- * defined in data_structs.h
+ * The whole token must be digits: "3abc" is reported as malformed rather than
+ * read as 3.
  *
- * @param fptr A pointer to the file from which to read.
- * @param line A pointer to a string read from the file.
+ * @param the string
+ * @param the integer value of the number represented by string if it is a number
+ *
+ * @return TRUE if string is a number, else FALSE
  */
-bool_t read_resources(FILE *fptr, char *line) {
-    char *resourceName;
-    bool_t success = TRUE;
-
-    /* If resource list provided */
-    if (strcmp(line, RESOURCES)==0) {
-        resourceName = malloc(NAME_SZ * sizeof(char));
-        /* While not the last resource */ 
-        while (read_string(fptr, resourceName) != 0) {
-            /* Load resource */ 
-            load_resource(resourceName);
-            resourceName = malloc(NAME_SZ * sizeof(char));
+bool_t str_to_int(char *string, int *value)
+{
+    char *start = string;
+    int number = 0, digit;
+
+    if (!isdigit((unsigned char) string[0])) return FALSE;
+
+    for (; isdigit((unsigned char) *string); string++) {
+        digit = *string - '0';
+        if (number > (INT_MAX - digit) / 10) {
+            printf("Number to high\n");
+            return FALSE;
         }
-        /* Load last resource */ 
-        load_resource(resourceName);
-        success = TRUE;
-    } else {
-#ifdef LOADER_DEBUG
-        printf("Note: no resource list provided\n"); 
-#endif
-        success = FALSE;
+        number = 10 * number + digit;
     }
-    
-    return success;
+    if (*string != '\0') {
+        fprintf(stderr, "Malformed number %s\n", start);
+        return FALSE;
+    }
+    *value = number;
+    return TRUE;
 }
 
 /**
- * @brief Reads the list of mailboxes and loads it.
+ * @brief Reads the list of processes and loads it with functions defined in
+ *     data_structs.h
  *
- * Reads the list of mailboxes and loads it with the load_mailbox function
- * defined in data_structs.h
+ * Each process name may be followed by its priority and then by its arrival
+ * time, written as @tick. A process without a priority gets priority 0; a
+ * process without an arrival time arrives when the manager decides.
  *
- * @param fptr A pointer to the file from which to read.
- * @param line A pointer to a string read from file.
+ * @param line The rest of the line after the PROCESSES keyword.
  */
-bool_t read_mailboxes(FILE *fptr, char *line) {
-    char *mailboxName;
-    bool_t success = TRUE;
-
-    /* If mailbox list provided */
-    if (strcmp(line, MAILBOXES)==0) {
-        mailboxName = malloc(strlen(line) * sizeof(char));
-        /* While not the last mailbox */ 
-        while (read_string(fptr, mailboxName) != 0) {
-            load_mailbox(mailboxName);
-            mailboxName = malloc(strlen(line) * sizeof(char));
+bool_t read_processes(line_t *line) {
+    char *process_name, *nxt_string;
+    int priority, arrival;
+
+    process_name = next_token(line);
+    while (process_name != NULL) {
+        priority = 0;
+        arrival = NO_ARRIVAL;
+        /* Read next string: priority, arrival or next process name */
+        nxt_string = next_token(line);
+        /* a token starting with a digit is a priority, even a malformed one,
+         * which leaves the default in place */
+        if (nxt_string != NULL && isdigit((unsigned char) nxt_string[0])) {
+            str_to_int(nxt_string, &priority);
+            nxt_string = next_token(line);
         }
-        /* Load last mailbox */ 
-        load_mailbox(mailboxName);
-        success = TRUE;
-    } else {
-#ifdef LOADER_DEBUG
-        printf("Note: no mailbox list provided\n"); 
-#endif
-        success = FALSE;
+        if (nxt_string != NULL && nxt_string[0] == '@') {
+            if (!isdigit((unsigned char) nxt_string[1]))
+                fprintf(stderr, "Malformed arrival %s of %s\n", nxt_string, process_name);
+            str_to_int(nxt_string + 1, &arrival);
+            nxt_string = next_token(line);
+        }
+        load_process(process_name, priority, arrival);
+        process_name = nxt_string;
     }
-    
-    return success;
+    return TRUE;
 }
 
 /**
- * @brief Reads the defined instruction for a process and loads it.
- *
- * Reads the list of instructions for each process and loads it in the
- * appropriate datastructure using the functions defined in data_structs.h
+ * @brief Reads the list of resources and loads it with functions defined in
+ *    data_structs.h
  *
- * @param fptr A pointer to the file from which to read.
- * @param line A pointer to a string read from file.
+ * Each resource name may be followed by its number of instances, e.g.
+ * "Resources R1 R2 3" declares one R1 and a pool of three R2. A resource
+ * without a number has one instance.
  *
- * @return s Indicates the current status of reading the process.
+ * @param line The rest of the line after the RESOURCES keyword.
  */
-int read_process(FILE *fptr, char *line) {
-    char *resource_name;
-    char *process_name;
-    char *msg;
-    int s;
-
-    s = 0; /* Must test this assignment */
-
-    if (strcmp(line, PROCESS) == 0) {
-        /* reads the process name */
-        process_name = malloc(sizeof(char)*3);
-        read_string(fptr, process_name); 
-        /* 1. Use the resource_name to find the relevant pcb */
-#ifdef DEBUG_LOADER
-        printf("Process %s\n", process_name);
-#endif 
-        resource_name = malloc(sizeof(char) * 64);
-        while ((s = read_string(fptr, resource_name)) != 0 && s != 2) {
-            if (strcmp(resource_name, REQ) == 0) {
-                /* Read the REQ resource */
-                read_req_resource(fptr, resource_name);
-                load_instruction(process_name, REQ_OP,
-                                 resource_name, NULL);
-                /* 2. Store instruction using the pcb pointer */
-            } else if (strcmp(resource_name, REL) == 0) {
-                /* Read the REL resource */
-                read_rel_resource(fptr, resource_name);
-                load_instruction(process_name, REL_OP, 
-                                 resource_name, NULL);
-            } else if (strcmp(resource_name, SEND) == 0) {
-                /* Read the COMMS resource */
-                msg = read_comms_send(fptr, resource_name);
-                load_instruction(process_name, SEND_OP, 
-                                 resource_name, msg);
-            } else if (strcmp(resource_name, RECV) == 0) {
-                /* Read the COMMS resource */
-                msg = read_comms_recv(fptr, resource_name);
-                load_instruction(process_name, RECV_OP, 
-                                 resource_name, msg);
-            } else {
-                /* Execute on white spaces */
-                /* Execute the while loop when encountering new lines and white 
-                 * spaces, exit the loop when encountering the instructions for
-                 * the next Process */
-                if (strcmp(resource_name, "") != 0) {
-                    break;
-                } else {
-                    free(resource_name);
-                }
-            }
-            resource_name = malloc(sizeof(char)*64);
+bool_t read_resources(line_t *line) {
+    char *resource_name, *nxt_string;
+    int instances;
+
+    resource_name = next_token(line);
+    while (resource_name != NULL) {
+        instances = 1;
+        nxt_string = next_token(line);
+        if (nxt_string != NULL && isdigit((unsigned char) nxt_string[0])) {
+            str_to_int(nxt_string, &instances);
+            nxt_string = next_token(line);
         }
-        free(resource_name);
+        load_resource(resource_name, instances);
+        resource_name = nxt_string;
     }
-    return s;
+    return TRUE;
 }
 
 /**
- * @brief Reads the resource name in a request instruction.
- *
- * Uses the read_string function to read the name of the resource specified in
- * this request instruction.
+ * @brief Reads a maximum claim, <code>claim R n</code>: the process holds at
+ *        most n instances of resource R at once.
  *
- * @param fptr A pointer to the file from which to read.
- * @param line A pointer to a string read from file.
+ * @param line The rest of the line after the resource name.
+ * @param process_name The process the claim belongs to.
+ * @param resource_name The claimed resource.
  */
-void read_req_resource(FILE *fptr, char *line) {
-    read_string(fptr, line);
-#ifdef DEBUG_LOADER
-    printf("req %s\n", line);
-#endif
-}
+void read_claim(line_t *line, char *process_name, char *resource_name) {
+    char *token = next_token(line);
+    int claim;
 
-/**
- * @brief Reads the resource name in a release instruction.
- *
- * Uses the read_string function to read the name of the resource specified in
- * this release instruction.
- *
- * @param fptr A pointer to the file from which to read.
- * @param line A pointer to a string read from file.
- */
-void read_rel_resource(FILE *fptr, char *line) {
-    read_string(fptr, line);
+    if (token == NULL || !str_to_int(token, &claim)) {
+        fprintf(stderr, "Malformed %s of %s\n", CLAIM, process_name);
+        return;
+    }
 #ifdef DEBUG_LOADER
-    printf("rel %s\n", line);
+    if (get_verbosity() >= VERBOSE_DEBUG) printf("%s %s %d\n", CLAIM, resource_name, claim);
 #endif
+    load_claim(process_name, resource_name, claim);
 }
 
 /**
- * @brief Reads the send instruction and the data.
- *
- * Reads all the elements from the send instruction and stores the mailbox as
- * well as the message to be loaded.
- *
- * @param fptr A pointer to the file from which to read.
- * @param line A pointer to a string read from file.
+ * @brief Reads the list of mailboxes and loads it.
  *
- * @return message The message which the instruction will send.
+ * @param line The rest of the line after the MAILBOXES keyword.
  */
-char *read_comms_send(FILE *fptr, char *line) {
-    int ch;
-    char *message;
-    int index;
-
-    message = malloc(sizeof(char) * 128);
-    for (index = 0; index < 128; index++) {
-        message[index] = '\0';
-    }
+bool_t read_mailboxes(line_t *line) {
+    char *mailbox_name;
 
-    while ((ch = fgetc(fptr)) != '\n') {
-        /* Check to make sure that the character is in the
-         * range of all the ascii letters */
-        if ((ch >= 65 && ch <= 90) || (ch >= 97 && ch <= 122)) {
-            index = 1;
-            line[0] = ch; 
-            while ((ch = fgetc(fptr)) != COMMA) {
-                if (ch != WHITESPACE) {
-                    line[index] = ch;
-                    index++;
-                }
-            }
-            /* Adds the termination character at the string end */
-            line[index] = '\0'; 
-            /* Remove leading whitespace */
-            while (isspace(ch = fgetc(fptr)));
-            /* Skip leading quotation mark */
-            if (ch == '"') {
-                ch = fgetc(fptr);
-            }
-
-            index = 0;
-             while (ch != RIGHTBRACKET) {
-                message[index] = ch;
-                index++;
-                ch = fgetc(fptr);
-            }
-            index--;
-            /* Remove trailing whitespace */
-            while (isspace(message[index])) {
-                message[index] = '\0';
-                index--;
-            }
-            /* Remove trailing quotation mark */
-            if (message[index] == '"') {
-                message[index] = '\0';
-            }
-        }
+    while ((mailbox_name = next_token(line)) != NULL) {
+        load_mailbox(mailbox_name);
     }
-#ifdef DEBUG_LOADER
-    printf("send (%s, %s)\n", line, message);
-#endif
-    return message;
+    return TRUE;
 }
 
 /**
- * @brief Reads the receive instruction and the data.
- *
- * Reads all the elements from the receive instruction and stores the mailbox as
- * well as the message to be loaded. In terms of the receive instruction, the
- * message is the variable in which to receive a message from the specified
- * mailbox. In order to conform to the specification, it has been included as a 
- * read message.
+ * @brief Reads a send or receive instruction and loads it.
  *
- * @param fptr A pointer to the file from which to read.
- * @param line A pointer to a string read from file.
+ * The instruction has the form <code>(mailbox, message)</code>. For a send
+ * the message is stripped of surrounding whitespace and quotation marks.
+ * In terms of the receive instruction, the message is the variable in which
+ * to receive a message from the specified mailbox; in order to conform to
+ * the specification it is loaded as the text between the comma and bracket.
  *
- * @return message A placeholder for the variable which receives the message.
+ * @param line The rest of the line after the SEND or RECV keyword.
+ * @param process_name The process the instruction belongs to.
+ * @param type SEND_OP or RECV_OP.
  */
-char *read_comms_recv(FILE *fptr, char *line) {
-    int ch;
-    char *message;
-    int index;
-
-    message = malloc(sizeof(char) * 128);
-    for (index = 0; index < 128; index++) {
-        message[index] = '\0';
+void read_comms(line_t *line, char *process_name, instr_types_t type) {
+    char *mailbox, *message, *comma, *bracket, *last;
+
+    mailbox = memchr(line->pos, LEFTBRACKET, line->end - line->pos);
+    comma = mailbox ? memchr(mailbox, COMMA, line->end - mailbox) : NULL;
+    bracket = comma ? memchr(comma, RIGHTBRACKET, line->end - comma) : NULL;
+    if (bracket == NULL) {
+        fprintf(stderr, "Malformed %s instruction of %s\n", (type == SEND_OP) ? SEND : RECV, process_name);
+        return;
     }
 
-    while ((ch = fgetc(fptr)) != '\n') {
-        /* Check to make sure that the character is in the
-        * range of all the ascii letters */
-        if ((ch >= 65 && ch <= 90) || (ch >= 97 && ch <= 122)) {
-            index = 1;
-            line[0] = ch; 
-            while ((ch = fgetc(fptr)) != COMMA) {
-                if (ch != WHITESPACE) {
-                    line[index] = ch;
-                    index++;
-                }
-            }
-            line[index] = '\0';
-            index = 0;
-            while ((ch = fgetc(fptr)) != RIGHTBRACKET) {
-                message[index] = ch;
-                index++;
-            }
-        }
+    /* Remove whitespace around the mailbox name */
+    for (mailbox++; mailbox < comma && isspace((unsigned char) *mailbox); mailbox++);
+    for (last = comma; last > mailbox && isspace((unsigned char) last[-1]); last--);
+    *last = '\0';
+
+    message = comma + 1;
+    last = bracket;
+    if (type == SEND_OP) {
+        /* Remove whitespace and quotation marks around the message */
+        while (message < last && isspace((unsigned char) *message)) message++;
+        if (message < last && *message == '"') message++;
+        while (last > message && isspace((unsigned char) last[-1])) last--;
+        if (last > message && last[-1] == '"') last--;
     }
+    *last = '\0';
+    line->pos = bracket + 1;
+
 #ifdef DEBUG_LOADER
-    printf("recv (%s, %s)\n", line, message);
+    if (get_verbosity() >= VERBOSE_DEBUG) printf("%s (%s, %s)\n", (type == SEND_OP) ? SEND : RECV, mailbox, message);
 #endif
-    return message;
-}
-
-/**
- * @brief Reads the next string.
- *
- * Reads the file character for character and constructs a string until a white
- * space or termination character is matched.
- *
- * @param fptr A pointer to the file from which to read.
- * @param line A pointer to space where the string can be stored.
- *
- * return status The status indicates when the END_OF_FILE or NEW LINE has 
- * been reached.
- */
-int read_string(FILE *fptr, char *line) {
-    int index = 0;
-    int ch = 0;
-    int status = 1;
-
-    ch = fgetc(fptr);
-    while (ch != '\n' && ch != ' ') {
-        if (ch == EOF) {
-            status = END_OF_FILE;
-            break;
-        }
-        line[index] = ch;
-        index++;
-        ch = fgetc(fptr);
-        status = (ch == '\n' ? 0 : 1);
-    }
-    line[index] = '\0';
-
-    return status;
+    load_instruction(process_name, type, mailbox, message);
 }
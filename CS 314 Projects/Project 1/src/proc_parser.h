@@ -8,6 +8,8 @@
 #ifndef _PARSER_H
 #define _PARSER_H
 
+#include "proc_structs.h"
+
 /**
  * @brief Reads in a specified file, parse it and store it in the associated
  *        data-structure.
@@ -19,6 +21,14 @@
  *
  * @param filename A string with the location of the process.list file for reading.
  */
-int parse_process_file(char* filename);
+int parse_process_file(sim_t *sim, char* filename);
+
+/**
+ * @brief Frees the memory of all the parsed process files.
+ *
+ * The names and messages passed to the loader point into the parsed files,
+ * so this must only be called once they are no longer used.
+ */
+void free_process_files(sim_t *sim);
 
 #endif
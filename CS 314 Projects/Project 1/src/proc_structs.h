@@ -6,24 +6,38 @@
 #ifndef STRUCTS_H
 #define STRUCTS_H
 
+#include <stddef.h>
+
 typedef enum {NEW = 0, READY, RUNNING, WAITING, TERMINATED} state_t;
 typedef enum {REQ_OP = 0, REL_OP, SEND_OP, RECV_OP} instr_types_t; 
 typedef enum {NO = 0, YES = 1} available_t; 
 typedef enum {FALSE = 0, TRUE = 1} bool_t;
 
-/** Each process has a linked list of instructions to execute.  */
-typedef struct instr_t {
-  instr_types_t type;
-  char *resource_name; /* any resource, including a mailbox */
-  char *msg; /* the message of a send or receive instruction */
-  struct instr_t *next;
-} instr_t;
+#define NO_ARRIVAL -1 /* the arrival time of a process that was not given one */
+#define NO_TICK -1 /* a time that has not been reached, e.g. the completion of a running process */
+#define NO_CPU -1 /* the cpu of a process that has not been placed on a simulated CPU */
+
+/** The state of one simulation, which every function of the loader works on, see sim.h */
+typedef struct sim_t sim_t;
 
-/** A process process_in_mem stores the name and instructions of a process */
+/** A process process_in_mem stores the name and instructions of a process.
+  *
+  * The instructions (the program) are stored as parallel arrays indexed by
+  * the program counter, so that running a process walks memory in order:
+  * the opcode of instruction i is ops[i] and its operand is ids[i]. Messages
+  * are only needed for logging and are kept apart in msgs. The arrays are
+  * filled by the loader and must not be changed until the memory is freed.
+  */
 typedef struct process_in_mem_t {
   int number; 
   char *name;
-  instr_t *first_instr; /* All the instructions of a process - should not be changed until the end of the program when the memory is freed */  
+  int num_instrs;
+  unsigned char *ops; /* instr_types_t of each instruction */
+  int *ids; /* resource id (req, rel) or mailbox id (send, recv), see get_resource() and get_mailbox_name() */
+  char **msgs; /* the message of each send or receive instruction, NULL for req and rel */
+  int num_claims;
+  int *claim_ids; /* resource id of each declared maximum claim */
+  int *claims; /* the most instances of that resource the process may hold at once */
 } process_in_mem_t;
 
 /** A type that represents a mailbox resource */
@@ -33,10 +47,13 @@ typedef struct mailbox_t {
   struct mailbox_t *next;
 } mailbox_t;
 
-/** A type that represents a resource */
+/** A type that represents a resource. The same type records a resource
+  * in the list of resources allocated to a process. */
 typedef struct resource_t {
   char *name;
-  available_t available; 
+  int id; /* dense id interned from the name, see get_resource() */
+  available_t available; /* YES while at least one instance is not held */
+  int instances; /* instances of the resource; in an allocation list, the instances held */
   struct resource_t *next;
 } resource_t;
 
@@ -47,71 +64,100 @@ typedef struct resource_t {
   * In this code the PCB points directly to a data structure,
   * called a process_in_mem, where the process instructions are stored.  
   *
-  * Note that next_instruction can point to any of the instructions in the
-  * linked list, for example, after the first instruction was executed,
-  * next_instruction will point to the 2nd instruction in the process's linked
-  * list of instructions stored in process_in_mem, while process_in_memo will
-  * still point to the first_instruction in the linked list. 
+  * Note that pc can index any of the instructions of the process, for
+  * example, after the first instruction was executed, pc will be 1, the index
+  * of the 2nd instruction stored in process_in_mem. The process has finished
+  * once pc reaches process_in_mem->num_instrs.
   */
 typedef struct pcb_t {
   struct process_in_mem_t *process_in_mem; /* process */
   int state; /* see enum state_t */
-  struct instr_t *next_instruction; /* a ptr to an instruction in the linked list of instructions */ 
+  int pc; /* index of the next instruction to execute in process_in_mem */
   int priority; /* used for priority based scheduling */ 
+  long arrival; /* tick at which the process enters the ready queue, or NO_ARRIVAL */
+  long first_run; /* tick of the first dispatch, or NO_TICK */
+  long ready_since; /* tick at which the process last entered the ready queue */
+  long wait; /* ticks spent in the ready queue */
+  long completion; /* tick at which the process terminated, or NO_TICK */
+  int cpu; /* simulated CPU whose run queue the process joins in SMP mode, or NO_CPU */
+  unsigned long vruntime; /* virtual runtime of the CFS scheduler: ticks run, weighted by priority */
+  struct pcb_t *tree_left, *tree_right, *tree_parent; /* links in a pcb_tree_t, see pcb_tree.h */
+  bool_t tree_red; /* colour in a pcb_tree_t */
+  unsigned long tree_seq; /* order of insertion into the pcb_tree_t */
   resource_t *resources; /* list of resources allocated to process */
   struct pcb_t *next;
 } pcb_t;
 
 /** Returns a pointer to the linked list of the loaded process pcbs */
-struct pcb_t* get_init_pcbs();
+struct pcb_t* get_init_pcbs(sim_t *sim);
 
 /** Returns a pointer to the linked list of the loaded process pcbs */
-struct pcb_t* get_new_pcb();
+struct pcb_t* get_new_pcb(sim_t *sim);
 
 /** Returns a pointer to the linked list of the loaded resources */
-struct resource_t* get_available_resources();
+struct resource_t* get_available_resources(sim_t *sim);
+
+/** Returns the loaded resource with id <code>id</code>, or NULL if no such resource was loaded */
+struct resource_t* get_resource(sim_t *sim, int id);
+
+/** Returns the number of resource ids handed out so far */
+int get_num_resource_ids(sim_t *sim);
+
+/** Returns the name of the resource with id <code>id</code>, loaded or not */
+char *get_resource_name(sim_t *sim, int id);
+
+/** Returns the name of the mailbox with id <code>id</code> */
+char *get_mailbox_name(sim_t *sim, int id);
+
+/** Returns the number of mailbox ids handed out so far */
+int get_num_mailbox_ids(sim_t *sim);
 
 /** Returns a pointer to the linked list of the loaded mailboxes */
-struct mailbox_t* get_mailboxes();
+struct mailbox_t* get_mailboxes(sim_t *sim);
 
 /** Returns a pointer to the linked list of the loaded process pcbs */
-int  get_num_procs();
+int  get_num_procs(sim_t *sim);
 
 /** Deallocates the memory that was allocated for the data structures */
-void dealloc_data_structures();
+void dealloc_data_structures(sim_t *sim);
 
-/** Deallocates the memory that was allocated for a pcb list */
-void dealloc_pcb_list();
+/** Allocates memory owned by the loader, released by dealloc_data_structures() */
+void *loader_alloc(sim_t *sim, size_t size);
 
-/** Deallocates the memory that was allocated for an instruction */
-void dealloc_instruction(struct instr_t *i);
+/** Copies a string into memory owned by the loader */
+char *loader_strdup(sim_t *sim, const char *str);
 
-/** Deallocates the memory that was allocated for a process name */
-void dealloc_last_proc_name();
+/** Stores the instructions loaded since the last call as the program of their process */
+void end_instructions(sim_t *sim);
 
 /** Returns a pointer to the pcb linked list of parsed processes */
-struct pcb_t* init_loader_from_files(char *filename1, char *filename2);
+struct pcb_t* init_loader_from_files(sim_t *sim, char *filename1, char *filename2);
 
 /** Returns a pointer to the pcb linked list of generated processes */
-struct pcb_t* init_loader_from_generator();
+struct pcb_t* init_loader_from_generator(sim_t *sim);
 
 /** Initialise the loader */
-void init_loader();
+void init_loader(sim_t *sim);
 
-/** Creates a pcb for process <code>process_name</code> with <code>priority</code> */
-bool_t load_process(char *process_name, int priority);
+/** Creates a pcb for process <code>process_name</code> with <code>priority</code>,
+  * arriving at tick <code>arrival</code> (or NO_ARRIVAL) */
+bool_t load_process(sim_t *sim, char *process_name, int priority, long arrival);
 
 /** Loads and stores an instruction of process <code>process_name</code> */
-bool_t load_instruction(char *process_name, instr_types_t instruction, 
+bool_t load_instruction(sim_t *sim, char *process_name, instr_types_t instruction, 
     char *resource_name, char *msg);
 
 /** Loads a mailbox */
-bool_t load_mailbox(char *mailboxName);
+bool_t load_mailbox(sim_t *sim, char *mailboxName);
+
+/** Loads a system resource <code>resource_name</code> with <code>instances</code> instances */
+bool_t load_resource(sim_t *sim, char *resource_name, int instances);
 
-/** Loads a system resource <code>resource_name</code> */
-bool_t load_resource(char *resource_name);
+/** Declares that process <code>process_name</code> holds at most <code>claim</code>
+  * instances of <code>resource_name</code> at once */
+bool_t load_claim(sim_t *sim, char *process_name, char *resource_name, int claim);
 
-/** Prints list of instructions last loaded */ 
-void print_instr_list(char *msg, instr_t *instructions);
+/** Prints the program of <code>proc</code>, or of the process whose instructions were loaded last */ 
+void print_instr_list(sim_t *sim, char *msg, process_in_mem_t *proc);
 
 #endif
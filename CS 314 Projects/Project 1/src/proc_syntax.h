@@ -12,6 +12,7 @@
 #define REL "rel"
 #define SEND "send"
 #define RECV "recv"
+#define CLAIM "claim"
 #define SYNC "sync"
 
 #define LEFTBRACKET 40
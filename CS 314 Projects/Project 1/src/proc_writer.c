@@ -0,0 +1,96 @@
+/**
+ * @file proc_writer.c
+ *
+ * The file is streamed out through a large stdio buffer as the lists are
+ * walked, so writing a workload of millions of processes needs no memory
+ * beyond the loaded processes themselves.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "proc_syntax.h"
+#include "proc_structs.h"
+#include "proc_writer.h"
+#include "sim.h"
+
+#define WRITE_BUF_SZ (1 << 20)
+
+void write_program(sim_t *sim, FILE *fptr, process_in_mem_t *proc);
+
+bool_t write_process_file(sim_t *sim, char *filename, pcb_t *pcbs, resource_t *resources,
+    mailbox_t *mailboxes) {
+    FILE *fptr = fopen(filename, "w");
+    pcb_t *pcb;
+    bool_t success;
+
+    if (fptr == NULL) {
+        fprintf(sim->err, "Error creating %s\n", filename);
+        return FALSE;
+    }
+    setvbuf(fptr, NULL, _IOFBF, WRITE_BUF_SZ);
+
+    fprintf(fptr, "%s", PROCESSES);
+    for (pcb = pcbs; pcb != NULL; pcb = pcb->next) {
+        fprintf(fptr, " %s %d", pcb->process_in_mem->name, pcb->priority);
+        if (pcb->arrival != NO_ARRIVAL) fprintf(fptr, " @%ld", pcb->arrival);
+    }
+    fprintf(fptr, "\n");
+
+    if (resources != NULL) {
+        fprintf(fptr, "%s", RESOURCES);
+        for (; resources != NULL; resources = resources->next) {
+            fprintf(fptr, " %s", resources->name);
+            if (resources->instances != 1) fprintf(fptr, " %d", resources->instances);
+        }
+        fprintf(fptr, "\n");
+    }
+
+    if (mailboxes != NULL) {
+        fprintf(fptr, "%s", MAILBOXES);
+        for (; mailboxes != NULL; mailboxes = mailboxes->next) {
+            fprintf(fptr, " %s", mailboxes->name);
+        }
+        fprintf(fptr, "\n");
+    }
+
+    for (pcb = pcbs; pcb != NULL; pcb = pcb->next) {
+        write_program(sim, fptr, pcb->process_in_mem);
+    }
+
+    success = !ferror(fptr);
+    if (fclose(fptr) != 0) success = FALSE;
+    if (!success) fprintf(sim->err, "Error writing %s\n", filename);
+    return success;
+}
+
+/**
+ * @brief Writes the Process section of one process, its claims first.
+ *
+ * A send message is quoted, as the parser strips quotes and whitespace around
+ * it. A receive message is written directly after the comma, as the parser
+ * keeps everything between the comma and the bracket.
+ */
+void write_program(sim_t *sim, FILE *fptr, process_in_mem_t *proc) {
+    int i;
+
+    fprintf(fptr, "\n%s %s\n", PROCESS, proc->name);
+    for (i = 0; i < proc->num_claims; i++) {
+        fprintf(fptr, " %s %s %d\n", CLAIM, get_resource_name(sim, proc->claim_ids[i]), proc->claims[i]);
+    }
+    for (i = 0; i < proc->num_instrs; i++) {
+        switch (proc->ops[i]) {
+        case REQ_OP:
+            fprintf(fptr, " %s %s\n", REQ, get_resource_name(sim, proc->ids[i]));
+            break;
+        case REL_OP:
+            fprintf(fptr, " %s %s\n", REL, get_resource_name(sim, proc->ids[i]));
+            break;
+        case SEND_OP:
+            fprintf(fptr, " %s (%s, \"%s\")\n", SEND, get_mailbox_name(sim, proc->ids[i]), proc->msgs[i]);
+            break;
+        case RECV_OP:
+            fprintf(fptr, " %s (%s,%s)\n", RECV, get_mailbox_name(sim, proc->ids[i]), proc->msgs[i]);
+            break;
+        }
+    }
+}
@@ -0,0 +1,28 @@
+/**
+  * @file proc_writer.h
+  * @description Writes loaded processes back out in the process.list format
+  *              read by the parser, so that generated workloads can be saved
+  *              and replayed.
+  */
+
+#ifndef _WRITER_H
+#define _WRITER_H
+
+/**
+ * @brief Writes a list of processes, with their programs, to a process file.
+ *
+ * The resources and mailboxes are declared in the file if they are not NULL.
+ * Parsing the file loads the same processes, priorities and programs.
+ *
+ * @param sim The simulation the processes were loaded into, which names their resources and mailboxes.
+ * @param filename The process file to create.
+ * @param pcbs The linked list of processes to write.
+ * @param resources The linked list of resources to declare, or NULL.
+ * @param mailboxes The linked list of mailboxes to declare, or NULL.
+ *
+ * @return TRUE if the file was written
+ */
+bool_t write_process_file(sim_t *sim, char *filename, pcb_t *pcbs, resource_t *resources,
+    mailbox_t *mailboxes);
+
+#endif
@@ -0,0 +1,64 @@
+/**
+ * @file sim.c
+ *
+ * A simulation owns everything a run needs, so nothing is shared between
+ * simulations but the read-only tables of the modules (e.g. the scheduling
+ * policies of the manager) and the SCHED_* environment variables, which are
+ * only read here.
+ */
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sim.h"
+
+void init_sim(sim_t *sim, char *dir)
+{
+    memset(sim, 0, sizeof(sim_t));
+    sim->dir = dir;
+    sim->out = stdout;
+    sim->err = stderr;
+
+    pthread_mutex_init(&sim->banker_lock, NULL);
+    pthread_mutex_init(&sim->ready_lock, NULL);
+    pthread_cond_init(&sim->work_ready, NULL);
+    pthread_cond_init(&sim->quiescent, NULL);
+    pthread_mutex_init(&sim->arrival_lock, NULL);
+    pthread_mutex_init(&sim->log.lock, NULL);
+
+    init_manager(sim);
+    init_loader(sim);
+    init_gen_config(&sim->gen.config);
+    init_logger(sim);
+    init_metrics(sim);
+}
+
+void free_sim(sim_t *sim)
+{
+    close_log(sim);
+    dealloc_data_structures(sim);
+
+    pthread_mutex_destroy(&sim->banker_lock);
+    pthread_mutex_destroy(&sim->ready_lock);
+    pthread_cond_destroy(&sim->work_ready);
+    pthread_cond_destroy(&sim->quiescent);
+    pthread_mutex_destroy(&sim->arrival_lock);
+    pthread_mutex_destroy(&sim->log.lock);
+}
+
+char *sim_path(sim_t *sim, const char *name)
+{
+    size_t len = strlen(name) + 1;
+    char *path;
+
+    if (sim->dir == NULL || name[0] == '/')
+    {
+        path = malloc(len);
+        memcpy(path, name, len);
+        return path;
+    }
+    path = malloc(strlen(sim->dir) + 1 + len);
+    sprintf(path, "%s/%s", sim->dir, name);
+    return path;
+}
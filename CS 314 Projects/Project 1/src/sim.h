@@ -0,0 +1,200 @@
+/**
+ * @file sim.h
+ * @description The state of one simulation: the manager's queues, clock and
+ *              counters, and the state of the loader, the generator, the
+ *              logger and the metrics. Every function of those modules takes
+ *              the simulation it works on, so any number of simulations can
+ *              run at once, each on its own thread (see batch.h).
+ */
+#ifndef _SIM_H
+#define _SIM_H
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "proc_structs.h"
+#include "manager.h"
+#include "pcb_heap.h"
+#include "pcb_tree.h"
+#include "name_table.h"
+#include "arena.h"
+#include "proc_gen.h"
+#include "logger.h"
+#include "metrics.h"
+
+/** The loader's lists and name tables, see proc_structs.h */
+typedef struct loader_t {
+  char *last_proc_name;
+  int last_proc_num;
+  pcb_t *first_pcb;
+  pcb_t *last_pcb;
+  name_table_t proc_names;    /* process name -> index into proc_table */
+  pcb_t **proc_table;         /* process name id -> pcb in the list being loaded, NULL if none */
+  int proc_table_sz;
+  resource_t *first_resource;
+  resource_t *last_resource;
+  name_table_t resource_names; /* resource name -> resource id */
+  resource_t **resource_table; /* resource id -> loaded resource, NULL until loaded */
+  int resource_table_sz;
+  name_table_t mailbox_names; /* mailbox name -> mailbox id */
+  mailbox_t *first_mailbox;
+  mailbox_t *last_mailbox;
+  /* the instructions of the process being loaded, copied into its
+   * process_in_mem by end_instructions() once they are all known */
+  pcb_t *loading_pcb;
+  unsigned char *staged_ops;
+  int *staged_ids;
+  char **staged_msgs;
+  int num_staged;
+  int staged_sz;
+  int *staged_claim_ids;
+  int *staged_claims;
+  int num_staged_claims;
+  int staged_claims_sz;
+  process_in_mem_t *last_program; /* the program stored last, for print_instr_list() */
+  arena_t arena;              /* owns every pcb, instruction, resource, mailbox and generated name */
+  struct process_file_t *process_files; /* the parsed files the names point into, see proc_parser.c */
+} loader_t;
+
+/** The generator's configuration and random state, see proc_gen.h */
+typedef struct gen_t {
+  gen_config_t config;
+  uint64_t rand_state;
+  char **resource_names;  /* generated names, shared by all instructions */
+  char **mailbox_names;
+  char **mailbox_msgs;
+  long arrival_tick;      /* arrival time of the current burst */
+  int burst_left;         /* processes still to arrive at arrival_tick */
+  int *held;              /* resources held by the process being generated, ascending unless deadlocks */
+  bool_t *is_held;        /* resource -> TRUE if in held */
+  int num_held;
+} gen_t;
+
+/** The logger's sink and buffer, see logger.h */
+typedef struct logger_t {
+  log_mode_t mode;
+  verbosity_t verbosity;
+  FILE *fptr;
+  char *buf;              /* lines held in memory before a write */
+  size_t len;
+  time_t last_flush;
+  unsigned long tick;     /* the logical clock stamped on trace records */
+  pthread_mutex_t lock;   /* every event is written whole: worker threads log concurrently */
+  struct trace_str_t *trace_strs; /* strings written to the trace so far */
+  size_t trace_strs_sz;
+  uint32_t trace_strs_used;
+} logger_t;
+
+/** The report format and the phase timer, see metrics.h */
+typedef struct metrics_t {
+  metrics_format_t format;
+  bool_t timing;          /* print the phase times */
+  double phase_ms[NUM_PHASES];
+  int cur_phase;          /* the phase being timed, -1 if none */
+  struct timespec phase_start;
+} metrics_t;
+
+/**
+ * A simulation. The manager's state comes first; see manager.c for the
+ * meaning of each queue and counter.
+ */
+struct sim_t {
+  char *dir;              /* directory of the log, trace, metrics and exported files; NULL for the working directory */
+  FILE *out;              /* printed output */
+  FILE *err;              /* error messages */
+
+  /* the queues */
+  int num_processes;
+  pcb_queue_t terminatedq;
+  pcb_queue_t *waitqs;    /* resource id -> FIFO of processes waiting for it */
+  int num_waitqs;
+  pcb_queue_t readyq;
+  pcb_heap_t readyh;      /* ready queue of the priority scheduler */
+  pcb_tree_t readyt;      /* ready queue of the completely fair scheduler */
+  pcb_t *last_ready;      /* pcb most recently made ready during this dispatch */
+  pcb_heap_t arrivals;    /* processes yet to arrive, earliest arrival first */
+  ready_order_t ready_order;  /* the order of the ready queue in use */
+  unsigned long min_vruntime; /* highest virtual runtime dispatched, the floor of a process made ready */
+  const struct sched_policy_t *policy; /* the policy of the run */
+  int slice;              /* ticks a dispatch may last under a sliced policy, 0 for no limit */
+  struct mailbox_buf_t *mailbox_bufs; /* mailbox id -> its buffer and blocked processes */
+  int num_mailbox_bufs;
+
+  /* the wait-for graph and deadlock recovery */
+  pcb_t **holders;        /* resource id -> process holding it */
+  int *waits_for;         /* process number -> resource id it waits for */
+  bool_t *deadlocked;     /* process number -> TRUE once found in a cycle */
+  victim_policy_t victim_policy;
+  pcb_t **cycle;          /* the last deadlock detected, not yet resolved */
+  int cycle_len;
+  int *rollbacks;         /* process number -> times rolled back */
+  int num_deadlocks;
+  int num_rolled_back;    /* instructions undone by deadlock recovery */
+
+  /* the clock, the resource instances and the metrics counters */
+  unsigned long clock_tick;  /* logical clock: one tick per executed instruction */
+  int *avail;                /* resource id -> instances not held */
+  resource_t *alloc_nodes;   /* one node per instance, recording it in a holder's list of resources */
+  resource_t **free_nodes;   /* resource id -> its nodes not in any holder's list */
+  unsigned long *held_since; /* resource id -> tick at which the instances held last changed */
+  unsigned long *busy_ticks; /* resource id -> instance-ticks it has been held */
+  unsigned long context_switches;
+  pcb_t *last_dispatched;
+
+  /* the SMP mode */
+  int num_cpus;
+  struct cpu_t *cpus;     /* the CPUs, while the SMP scheduler runs */
+
+  /* the Banker's algorithm (VICTIM_AVOID) */
+  int *max_claim;         /* process x resource -> most instances it may hold */
+  int *allocated;         /* process x resource -> instances it holds */
+  int *num_held;          /* process number -> instances it holds of all resources */
+  unsigned long *holding; /* bitset of the process numbers holding an instance */
+  unsigned long *finished; /* bitset scratch of is_safe() */
+  int *work;              /* resource id -> scratch of is_safe() */
+  int bitset_words;
+  pcb_queue_t unsafe_waitq; /* processes whose request would have left an unsafe state */
+  pthread_mutex_t banker_lock; /* the state above, while threads avoid deadlocks */
+
+  /* the threaded backend */
+  int num_threads;        /* worker threads, 0 to simulate the CPUs instead */
+  bool_t threaded;        /* TRUE while worker threads run the processes */
+  pthread_mutex_t *resource_locks; /* resource id -> lock of its holder, wait queue and counters,
+                                      then one lock per mailbox */
+  pthread_mutex_t ready_lock;   /* the ready and terminated queues */
+  pthread_cond_t work_ready;    /* a process was made ready or the run ended */
+  pthread_cond_t quiescent;     /* no process is running or ready */
+  pthread_mutex_t arrival_lock; /* the arrivals heap */
+  long next_arrival;      /* arrival tick of the next process to arrive */
+  pcb_t *ready_first;     /* the best ready process of a heap or tree, read by running workers */
+  int busy_workers;       /* workers running a process */
+  bool_t workers_done;    /* set to make the idle workers exit */
+
+  loader_t loader;
+  gen_t gen;
+  logger_t log;
+  metrics_t metrics;
+};
+
+/**
+ * @brief Initialises a simulation with the default settings, and those of
+ *        the SCHED_* environment variables, printing to stdout and stderr.
+ *
+ * @param dir The directory of the files the simulation writes, NULL for the
+ *     working directory. It must exist and outlive the simulation.
+ */
+void init_sim(sim_t *sim, char *dir);
+
+/** @brief Closes the log of a simulation and frees everything it still owns */
+void free_sim(sim_t *sim);
+
+/**
+ * @brief Returns the path of the file <code>name</code> written by the
+ *        simulation, in its directory unless <code>name</code> is absolute.
+ *        The caller frees the path.
+ */
+char *sim_path(sim_t *sim, const char *name);
+
+#endif
@@ -0,0 +1,51 @@
+/**
+  * @file trace.h
+  * @description The record layout of the binary event trace (scheduler.trace)
+  *              written by the logger in LOG_TRACE mode and read by trace_decode.
+  */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+
+#define TRACE_FILENAME "scheduler.trace"
+#define TRACE_MAGIC 0x43525453 /* "STRC" */
+#define TRACE_VERSION 2 /* 2: 64-bit ticks */
+#define TRACE_NONE 0 /* string id used when a record has no such field */
+
+/** The event types, one per log_* function, plus the bookkeeping records */
+typedef enum {
+  TRACE_HEADER = 0,  /* proc = TRACE_MAGIC, resource = TRACE_VERSION */
+  TRACE_STRING,      /* proc = string id, resource = length, bytes follow */
+  TRACE_ACQUIRED,
+  TRACE_WAITING,
+  TRACE_READY,
+  TRACE_RELEASED,
+  TRACE_RELEASE_ERROR,
+  TRACE_TERMINATED,
+  TRACE_SEND,
+  TRACE_RECV,
+  TRACE_DEADLOCK,
+  TRACE_BLOCKED,
+  TRACE_MEMBER,      /* a process listed after TRACE_DEADLOCK or TRACE_BLOCKED */
+  TRACE_END,         /* ends the list of processes */
+  TRACE_SEND_WAITING,
+  TRACE_RECV_WAITING
+} trace_event_t;
+
+/**
+  * A fixed-size trace record. Process, resource (or mailbox) and message are
+  * ids into the string table built by the TRACE_STRING records that precede
+  * their first use. The bytes of a string are stored in the records directly
+  * after its TRACE_STRING record, padded to a whole number of records.
+  */
+typedef struct trace_rec_t {
+  uint32_t type;     /* see trace_event_t */
+  uint32_t proc;
+  uint32_t resource;
+  uint32_t msg;
+  uint64_t tick;     /* logical clock of the manager when the event occurred */
+} trace_rec_t;
+
+#endif
@@ -0,0 +1,105 @@
+#!/bin/sh
+#
+# bench.sh - times schedule_processes on generated workloads of increasing size
+#
+# Usage: tools/bench.sh [-n runs] [-s sizes] [-a schedulers] [-q quantum] [executable]
+#   -n  runs of each scheduler on each workload (default 5)
+#   -s  workload sizes, e.g. "1000 10000 100000" (the default)
+#   -a  schedulers to run, e.g. "0 1 2 3" (the default)
+#   -q  time quantum of the RR and CFS schedulers (default 2)
+#   executable defaults to ./schedule_processes_fast (see "make fast")
+#
+# For each size, a workload of <size> initial and <size> arriving processes is
+# generated once and exported, then every scheduler replays it <runs> times.
+# Each run reports the wall-clock time of its parse, load, schedule and
+# teardown phases (SCHED_TIMING=1). One CSV row per size, scheduler and phase
+# gives the median and the sample variance of that phase over the runs.
+# Extra generator settings can be given in BENCH_GEN, e.g. BENCH_GEN=burst=8.
+
+runs=5
+sizes="1000 10000 100000"
+scheds="0 1 2 3"
+quantum=2
+
+while getopts n:s:a:q: opt; do
+    case $opt in
+    n) runs=$OPTARG ;;
+    s) sizes=$OPTARG ;;
+    a) scheds=$OPTARG ;;
+    q) quantum=$OPTARG ;;
+    *) sed -n '5,10s/^# //p' "$0" >&2; exit 2 ;;
+    esac
+done
+shift $((OPTIND - 1))
+
+exe=${1:-./schedule_processes_fast}
+if [ ! -x "$exe" ]; then
+    echo "bench: $exe not found, build it with make fast" >&2
+    exit 1
+fi
+exe=$(cd "$(dirname "$exe")" && pwd)/$(basename "$exe")
+
+# run in a scratch directory, so the workloads and logs do not pile up
+work=$(mktemp -d) || exit 1
+trap 'rm -rf "$work"' EXIT
+cd "$work" || exit 1
+
+echo "size,scheduler,phase,runs,median_ms,variance_ms2"
+for size in $sizes; do
+    resources=$((size / 100))
+    [ $resources -lt 5 ] && resources=5
+    settings="seed=1,procs=$size,new_procs=$size,resources=$resources,min_instrs=2,max_instrs=16,max_priority=20,export=w"
+    if ! SCHED_VERBOSITY=quiet "$exe" generate "$settings${BENCH_GEN:+,$BENCH_GEN}" 2 "$quantum" > /dev/null; then
+        echo "bench: generating $size processes failed" >&2
+        exit 1
+    fi
+
+    for sched in $scheds; do
+        case $sched in
+        0) name=priority ;;
+        1) name=RR ;;
+        3) name=CFS ;;
+        *) name=FCFS ;;
+        esac
+
+        : > times
+        i=0
+        while [ $i -lt "$runs" ]; do
+            rm -f scheduler.log
+            SCHED_VERBOSITY=quiet SCHED_TIMING=1 "$exe" w1.list w2.list "$sched" "$quantum" 2>> times > /dev/null
+            i=$((i + 1))
+        done
+
+        awk -v size="$size" -v sched="$name" '
+            /^phase_ms / {
+                for (i = 2; i <= NF; i++) {
+                    split($i, kv, "=")
+                    if (!(kv[1] in n))
+                        order[++num_phases] = kv[1]
+                    v[kv[1], ++n[kv[1]]] = kv[2]
+                }
+            }
+            END {
+                for (p = 1; p <= num_phases; p++) {
+                    phase = order[p]
+                    m = n[phase]
+                    for (i = 1; i <= m; i++)
+                        a[i] = v[phase, i]
+                    for (i = 2; i <= m; i++) {
+                        x = a[i]
+                        for (j = i - 1; j >= 1 && a[j] > x; j--)
+                            a[j + 1] = a[j]
+                        a[j + 1] = x
+                    }
+                    median = (m % 2) ? a[(m + 1) / 2] : (a[m / 2] + a[m / 2 + 1]) / 2
+                    sum = 0
+                    for (i = 1; i <= m; i++)
+                        sum += a[i]
+                    ss = 0
+                    for (i = 1; i <= m; i++)
+                        ss += (a[i] - sum / m) ^ 2
+                    printf "%s,%s,%s,%d,%.3f,%.3f\n", size, sched, phase, m, median, (m > 1) ? ss / (m - 1) : 0
+                }
+            }' times
+    done
+done
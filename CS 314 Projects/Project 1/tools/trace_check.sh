@@ -0,0 +1,81 @@
+#!/bin/sh
+#
+# trace_check.sh - checks that a binary trace decodes to the text log
+#
+# Usage: tools/trace_check.sh [executable] [decoder]
+#   executable defaults to ./schedule_processes, decoder to ./trace_decode
+#
+# Runs a workload in which a receiver blocks on an empty mailbox and a sender
+# on a full one, once with the text log and once with SCHED_LOG_MODE=trace.
+# The decoded trace must equal scheduler.log, and with -t every event line,
+# the send and receive waits included, must carry a tick, and the lines must
+# equal those of the plain decode once the ticks are stripped.
+
+exe=${1:-./schedule_processes}
+decoder=${2:-./trace_decode}
+for f in "$exe" "$decoder"; do
+    if [ ! -x "$f" ]; then
+        echo "trace_check: $f not found, build it with make" >&2
+        exit 1
+    fi
+done
+exe=$(cd "$(dirname "$exe")" && pwd)/$(basename "$exe")
+decoder=$(cd "$(dirname "$decoder")" && pwd)/$(basename "$decoder")
+
+work=$(mktemp -d) || exit 1
+trap 'rm -rf "$work"' EXIT
+cd "$work" || exit 1
+
+# P1 receives before anything is sent; P2 sends one message more than the
+# mailbox holds once P1 has taken the first
+cat > p1.list <<'EOF'
+Processes P1 1 P2 2
+Mailboxes M1
+
+Process P1
+ recv (M1, x)
+ send (M1, "done")
+
+Process P2
+ send (M1, "a")
+ send (M1, "b")
+ send (M1, "c")
+ send (M1, "d")
+ send (M1, "e")
+ send (M1, "f")
+ send (M1, "g")
+ send (M1, "h")
+ send (M1, "i")
+ send (M1, "j")
+EOF
+echo "Processes" > p2.list
+
+fail=0
+SCHED_VERBOSITY=quiet "$exe" p1.list p2.list 2 2 > /dev/null
+SCHED_VERBOSITY=quiet SCHED_LOG_MODE=trace "$exe" p1.list p2.list 2 2 > /dev/null
+"$decoder" > decoded
+"$decoder" -t > ticked
+
+if ! diff scheduler.log decoded > /dev/null; then
+    echo "trace_check: the decoded trace differs from scheduler.log:" >&2
+    diff scheduler.log decoded >&2
+    fail=1
+fi
+for wait in "recv M1: waiting" "send M1: waiting"; do
+    if ! grep -q "^\[[0-9]*\] P[12] $wait\$" ticked; then
+        echo "trace_check: no ticked \"$wait\" line in trace_decode -t" >&2
+        fail=1
+    fi
+done
+# the two header lines of a run are written as strings, without a tick
+if sed -e '/^Arguments:/d' -e '/^\*/d' ticked | grep -v '^\[[0-9]*\] ' >&2; then
+    echo "trace_check: the lines above have no tick" >&2
+    fail=1
+fi
+if ! sed 's/^\[[0-9]*\] //' ticked | diff decoded - > /dev/null; then
+    echo "trace_check: trace_decode -t differs from trace_decode beyond the ticks" >&2
+    fail=1
+fi
+
+[ $fail -eq 0 ] && echo "trace_check: ok"
+exit $fail
@@ -0,0 +1,161 @@
+/**
+ * @file trace_decode.c
+ * @description Turns a binary scheduler.trace back into the text that the
+ *              logger writes to scheduler.log.
+ *
+ * Usage: trace_decode [-s] [-t] [trace_file]
+ *   -s  print the stdout form of the log, which includes "terminated" lines
+ *   -t  prefix every line with the logical tick at which it was logged
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/trace.h"
+
+static char **strs = NULL;
+static size_t strs_sz = 0;
+
+/* Frees the string table of the current run */
+static void clear_strs() {
+    size_t i;
+
+    for (i = 0; i < strs_sz; i++)
+        free(strs[i]);
+    free(strs);
+    strs = NULL;
+    strs_sz = 0;
+}
+
+/* Reads a TRACE_STRING payload and stores it under id */
+static int read_str(FILE *fptr, uint32_t id, uint32_t len) {
+    size_t padded = (len + sizeof(trace_rec_t) - 1) / sizeof(trace_rec_t) * sizeof(trace_rec_t);
+    char *str = malloc(padded + 1);
+
+    if (!str || fread(str, 1, padded, fptr) != padded) {
+        free(str);
+        return 0;
+    }
+    str[len] = '\0';
+
+    if (id >= strs_sz) {
+        size_t new_sz = strs_sz ? strs_sz : 256;
+        while (new_sz <= id)
+            new_sz *= 2;
+        strs = realloc(strs, new_sz * sizeof(char *));
+        memset(strs + strs_sz, 0, (new_sz - strs_sz) * sizeof(char *));
+        strs_sz = new_sz;
+    }
+    free(strs[id]);
+    strs[id] = str;
+    return 1;
+}
+
+/* Returns the string with trace id <code>id</code> */
+static char *str(uint32_t id) {
+    if (id == TRACE_NONE || id >= strs_sz || !strs[id])
+        return "(null)";
+    return strs[id];
+}
+
+/* Tells whether a record type only structures the trace, so it gets no tick */
+static int is_bookkeeping(uint32_t type) {
+    return type == TRACE_HEADER || type == TRACE_STRING
+        || type == TRACE_MEMBER || type == TRACE_END;
+}
+
+int main(int argc, char **argv) {
+    FILE *fptr;
+    trace_rec_t rec;
+    char *filename = TRACE_FILENAME;
+    int with_stdout = 0, with_ticks = 0, i;
+
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-s") == 0)
+            with_stdout = 1;
+        else if (strcmp(argv[i], "-t") == 0)
+            with_ticks = 1;
+        else
+            filename = argv[i];
+    }
+
+    fptr = fopen(filename, "rb");
+    if (!fptr) {
+        fprintf(stderr, "Error opening %s\n", filename);
+        return EXIT_FAILURE;
+    }
+
+    while (fread(&rec, sizeof(rec), 1, fptr) == 1) {
+        if (with_ticks && !is_bookkeeping(rec.type)
+                && (rec.type != TRACE_TERMINATED || with_stdout))
+            printf("[%" PRIu64 "] ", rec.tick);
+
+        switch (rec.type) {
+        case TRACE_HEADER:
+            if (rec.proc != TRACE_MAGIC || rec.resource != TRACE_VERSION) {
+                fprintf(stderr, "%s: not a version %d trace\n", filename, TRACE_VERSION);
+                return EXIT_FAILURE;
+            }
+            clear_strs(); /* a new run was appended */
+            break;
+        case TRACE_STRING:
+            if (!read_str(fptr, rec.proc, rec.resource)) {
+                fprintf(stderr, "%s: truncated string record\n", filename);
+                return EXIT_FAILURE;
+            }
+            break;
+        case TRACE_ACQUIRED:
+            printf("%s req %s: acquired\n", str(rec.proc), str(rec.resource));
+            break;
+        case TRACE_WAITING:
+            printf("%s req %s: waiting\n", str(rec.proc), str(rec.resource));
+            break;
+        case TRACE_READY:
+            printf("%s: ready\n", str(rec.proc));
+            break;
+        case TRACE_RELEASED:
+            printf("%s rel %s: released\n", str(rec.proc), str(rec.resource));
+            break;
+        case TRACE_RELEASE_ERROR:
+            printf("%s rel %s: error nothing to release\n", str(rec.proc), str(rec.resource));
+            break;
+        case TRACE_TERMINATED:
+            if (with_stdout)
+                printf("%s terminated\n", str(rec.proc));
+            break;
+        case TRACE_SEND:
+            printf("%s sending message%s to mailbox %s\n", str(rec.proc), str(rec.msg), str(rec.resource));
+            break;
+        case TRACE_RECV:
+            printf("%s received message%s from mailbox %s\n", str(rec.proc), str(rec.msg), str(rec.resource));
+            break;
+        case TRACE_DEADLOCK:
+            printf("Deadlock detected:");
+            break;
+        case TRACE_BLOCKED:
+            printf("No deadlock detected, but blocked process(es) found:");
+            break;
+        case TRACE_MEMBER:
+            printf(" %s", str(rec.proc));
+            break;
+        case TRACE_END:
+            printf("\n");
+            break;
+        case TRACE_SEND_WAITING:
+            printf("%s send %s: waiting\n", str(rec.proc), str(rec.resource));
+            break;
+        case TRACE_RECV_WAITING:
+            printf("%s recv %s: waiting\n", str(rec.proc), str(rec.resource));
+            break;
+        default:
+            fprintf(stderr, "%s: unknown record type %u\n", filename, rec.type);
+            return EXIT_FAILURE;
+        }
+    }
+
+    clear_strs();
+    fclose(fptr);
+    return EXIT_SUCCESS;
+}